@@ -0,0 +1,50 @@
+#pragma once
+
+#include "imgui.h"
+#include "implot.h"
+
+// Dear ImGui + ImPlot context without any platform or renderer backend. Frames are built into ImDrawData and
+// never submitted anywhere, which is exactly the CPU cost of the widgets that we want to measure.
+class HeadlessContext
+{
+public:
+    HeadlessContext()
+    {
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImPlot::CreateContext();
+
+        ImGuiIO& io = ImGui::GetIO();
+        io.IniFilename = NULL;
+        io.LogFilename = NULL;
+        io.DisplaySize = ImVec2(1280, 720);
+        io.DeltaTime = 1.f / 60.f;
+
+        // No renderer backend builds the font atlas for us.
+        unsigned char* pixels = NULL;
+        int width = 0, height = 0;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+        ImGui::StyleColorsDark();
+    }
+
+    ~HeadlessContext()
+    {
+        ImPlot::DestroyContext();
+        ImGui::DestroyContext();
+    }
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    void new_frame()
+    {
+        ImGui::NewFrame();
+    }
+
+    ImDrawData* render()
+    {
+        ImGui::Render();
+        return ImGui::GetDrawData();
+    }
+};
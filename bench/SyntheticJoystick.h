@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scripted joystick stream used by the benchmark. Produces the same kind of data glfwGetJoystickAxes() and
+// glfwGetJoystickButtons() return, deterministically, so runs are comparable with each other.
+class SyntheticJoystick
+{
+public:
+    enum Pattern
+    {
+        Pattern_Sticks      = 1 << 0, // Smooth circular motion on every axis pair.
+        Pattern_Noise       = 1 << 1, // Small random jitter added to every axis on every step.
+        Pattern_ButtonStorm = 1 << 2, // Every button toggles randomly on every step.
+        Pattern_Paint       = 1 << 3, // Paint button (13) held down the whole time.
+    };
+
+    SyntheticJoystick(int joystick_id, int axes_count, int button_count, int patterns)
+        : m_axes(axes_count, 0.f),
+          m_buttons(button_count, 0),
+          m_name("Synthetic joystick " + std::to_string(joystick_id)),
+          m_joystickId(joystick_id),
+          m_patterns(patterns),
+          m_rng(0x9E3779B9u ^ static_cast<uint32_t>(joystick_id + 1) * 0x85EBCA6Bu)
+    {
+    }
+
+    void step(int step_index)
+    {
+        const float t = step_index * (1.f / 60.f);
+        m_timestamp = t;
+
+        for (int i = 0; i < axes_count(); ++i)
+        {
+            float value = 0.f;
+            if (m_patterns & Pattern_Sticks)
+                value = (i % 2 == 0) ? std::cos(t + i * 0.5f) : std::sin(t + (i - 1) * 0.5f);
+            if (m_patterns & Pattern_Noise)
+                value += (next_float() - 0.5f) * 0.02f;
+            m_axes[i] = value;
+        }
+
+        for (int i = 0; i < button_count(); ++i)
+        {
+            uint8_t pressed = 0;
+            if (m_patterns & Pattern_ButtonStorm)
+                pressed = next_uint() & 1u;
+            if ((m_patterns & Pattern_Paint) && i == 13)
+                pressed = 1;
+            m_buttons[i] = pressed;
+        }
+    }
+
+    int axes_count() const { return static_cast<int>(m_axes.size()); }
+    int button_count() const { return static_cast<int>(m_buttons.size()); }
+
+    const float* axes() const { return m_axes.data(); }
+    const uint8_t* buttons() const { return m_buttons.data(); }
+    const std::string& name() const { return m_name; }
+    double timestamp() const { return m_timestamp; }
+    int joystick_id() const { return m_joystickId; }
+
+private:
+    uint32_t next_uint()
+    {
+        // xorshift32
+        m_rng ^= m_rng << 13;
+        m_rng ^= m_rng >> 17;
+        m_rng ^= m_rng << 5;
+        return m_rng;
+    }
+
+    float next_float()
+    {
+        return (next_uint() >> 8) * (1.f / 16777216.f);
+    }
+
+private:
+    std::vector<float> m_axes;
+    std::vector<uint8_t> m_buttons;
+    std::string m_name;
+    int m_joystickId;
+    int m_patterns;
+    uint32_t m_rng;
+    double m_timestamp = 0;
+};
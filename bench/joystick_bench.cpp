@@ -0,0 +1,679 @@
+// Native headless benchmark for JoystickWidget.
+// Drives the widget with scripted joystick streams and reports the cost of JoystickWidget::update(), the cost of a
+// whole ImGui/ImPlot frame (widget build + ImGui::Render), the size of the resulting draw lists and the number of heap
+// allocations done on the way. Percentiles come from the same FrameProfiler the app's "Frame timing" window uses; input
+// age is only meaningful for sampled scenarios, the others use synthetic timestamps.
+//
+// --record writes every sample of the run to a session recording, --replay plays a recording back as fast as possible
+// through the same JoystickWidget::update() path instead of running the scenarios, see SessionRecording.h. Replaying
+// a recording is deterministic, which makes it both a throughput benchmark and a way to reproduce a captured session.
+// The recording is then replayed a second time and has to decode exactly like the first (exit status 1 otherwise).
+//
+// --telemetry streams every sample and the changes the widgets detected to a local socket (TelemetryExporter.h), for
+// tools/telemetry_receiver or other consumers.
+//
+// --filters measures the axis filter pipeline (AxisFilters.h) alone instead: 16 devices sampled at 1 kHz, filtered in
+// the batches a 60 Hz main loop drains, once per smoothing mode, with calibration, deadzones and a response curve set.
+//
+// --simplifier checks the painted path's PolylineSimplifier instead: every point of a jittery Lissajous trace has to
+// end up within the tolerance of the simplified path (exit status 1 otherwise).
+//
+// The peak live heap per subsystem of the whole run is printed at the end (AllocationCounter.h), a starting point for
+// the app's JOYSTICK_INITIAL_MEMORY.
+//
+// Steady-state frames must not allocate: the exit status is 1 if any frame after the warm-up did (see
+// AllocationCounter.h), except with --record, whose recording grows as it goes.
+//
+// Usage: joystick_bench [--frames N] [--warmup N] [--scenario name] [--record file | --replay file]
+//                       [--telemetry udp:host:port | unix:path] [--filters] [--simplifier]
+
+#define ALLOCATION_COUNTER_IMPLEMENTATION
+#include "AllocationCounter.h"
+#include "AxisFilters.h"
+#include "HeadlessContext.h"
+#include "SyntheticJoystick.h"
+#include "JoystickWidget.h"
+#include "InputSampler.h"
+#include "FrameProfiler.h"
+#include "SessionRecording.h"
+#include "TelemetryExporter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+struct Scenario
+{
+    const char* name;
+    int devices;
+    int axes_count;
+    int button_count;
+    int patterns;
+    double sample_rate; // 0: one update per device and frame, otherwise sampled by an InputSampler at this rate.
+};
+
+static const Scenario g_scenarios[] = {
+    { "sticks",       1,  6, 18, SyntheticJoystick::Pattern_Sticks, 0 },
+    { "many-axes",    1, 16, 32, SyntheticJoystick::Pattern_Sticks, 0 },
+    { "noisy-sticks", 1,  6, 18, SyntheticJoystick::Pattern_Sticks | SyntheticJoystick::Pattern_Noise, 0 },
+    { "button-storm", 1,  6, 32, SyntheticJoystick::Pattern_Sticks | SyntheticJoystick::Pattern_ButtonStorm, 0 },
+    { "paint",        1,  6, 18, SyntheticJoystick::Pattern_Sticks | SyntheticJoystick::Pattern_Paint, 0 },
+    { "16-devices",  16,  6, 18, SyntheticJoystick::Pattern_Sticks | SyntheticJoystick::Pattern_Noise, 0 },
+    { "sampled-1khz", 4,  6, 18, SyntheticJoystick::Pattern_Sticks | SyntheticJoystick::Pattern_Noise, 1000 },
+};
+
+struct BenchOptions
+{
+    int frames = 2000;
+    int warmup = 120;
+    const char* scenario = NULL;
+    const char* record = NULL;
+    const char* replay = NULL;
+    const char* telemetry = NULL;
+    bool filters = false;
+    bool simplifier = false;
+};
+
+struct BenchResult
+{
+    double updates_per_frame = 0;
+    double ns_per_update = 0;
+    double ns_per_frame = 0;
+    double vertices_per_frame = 0;
+    int max_vertices = 0;
+    double allocs_per_frame = 0;
+    double alloc_bytes_per_frame = 0;
+    uint64_t allocating_frames = 0;
+    FrameMetricStats frame;
+    FrameMetricStats input_age;
+};
+
+typedef std::chrono::steady_clock BenchClock;
+
+static int64_t elapsed_ns(BenchClock::time_point begin, BenchClock::time_point end)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+}
+
+// Sends a sample, and the changes the widget detected in it, to the telemetry stream.
+static void export_telemetry(TelemetryExporter* telemetry, const JoystickSample& sample, const JoystickWidget& widget)
+{
+    if (!telemetry)
+        return;
+    telemetry->export_sample(sample);
+    telemetry->export_changes(sample, widget.changed_axes(), widget.changed_buttons());
+}
+
+static BenchResult run_scenario(const Scenario& scenario, const BenchOptions& options, SessionRecorder* recorder,
+                                TelemetryExporter* telemetry)
+{
+    HeadlessContext context;
+
+    JoystickEventLog events;
+    std::vector<SyntheticJoystick> joysticks;
+    std::vector<std::unique_ptr<JoystickWidget>> widgets;
+    for (int i = 0; i < scenario.devices; ++i)
+    {
+        joysticks.emplace_back(i, scenario.axes_count, scenario.button_count, scenario.patterns);
+        widgets.emplace_back(new JoystickWidget("Joystick widget " + std::to_string(i)));
+        widgets.back()->set_event_log(&events);
+        widgets.back()->set_device(i, joysticks.back().name().c_str());
+    }
+
+    // In sampled scenarios the synthetic joysticks belong to the sampler thread from here on.
+    InputSampler sampler;
+    int sample_step = 0;
+    if (scenario.sample_rate > 0)
+    {
+        sampler.start([&joysticks, &sample_step](double timestamp, JoystickSample* samples, int max_samples) {
+            int count = 0;
+            for (SyntheticJoystick& joystick : joysticks)
+            {
+                if (count == max_samples)
+                    break;
+                joystick.step(sample_step);
+                samples[count++].set(joystick.joystick_id(), timestamp, joystick.axes_count(), joystick.axes(),
+                                     joystick.button_count(), joystick.buttons());
+            }
+            ++sample_step;
+            return count;
+        }, scenario.sample_rate);
+    }
+
+    FrameProfiler profiler;
+    FrameAllocations frame_allocations(options.warmup);
+    BenchResult result;
+    int64_t update_ns = 0;
+    int64_t updates = 0;
+    int64_t frame_ns = 0;
+    int64_t vertices = 0;
+    uint64_t allocs_begin = 0;
+    uint64_t alloc_bytes_begin = 0;
+
+    const int total_frames = options.warmup + options.frames;
+    for (int frame = 0; frame < total_frames; ++frame)
+    {
+        const bool measured = frame >= options.warmup;
+        if (frame == options.warmup)
+        {
+            allocs_begin = allocation_counter::count();
+            alloc_bytes_begin = allocation_counter::bytes();
+            profiler.reset();
+        }
+
+        profiler.begin_frame(now_seconds());
+        {
+            ScopedFrameTimer timer(profiler, FrameMetric_Update);
+            if (scenario.sample_rate > 0)
+            {
+                const BenchClock::time_point begin = BenchClock::now();
+                const int drained = sampler.drain([&widgets, &profiler, recorder,
+                                                   telemetry](const JoystickSample& sample) {
+                    widgets[sample.joystick_id]->update(sample);
+                    profiler.add_input(sample.timestamp);
+                    if (recorder)
+                        recorder->record(sample);
+                    export_telemetry(telemetry, sample, *widgets[sample.joystick_id]);
+                });
+                if (measured)
+                {
+                    update_ns += elapsed_ns(begin, BenchClock::now());
+                    updates += drained;
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < joysticks.size(); ++i)
+                {
+                    SyntheticJoystick& joystick = joysticks[i];
+                    joystick.step(frame);
+
+                    const BenchClock::time_point begin = BenchClock::now();
+                    widgets[i]->update(joystick.axes_count(), joystick.axes(),
+                                       joystick.button_count(), joystick.buttons(),
+                                       joystick.name().c_str(), joystick.joystick_id(), joystick.timestamp());
+                    if (measured)
+                    {
+                        update_ns += elapsed_ns(begin, BenchClock::now());
+                        ++updates;
+                    }
+
+                    if (recorder || telemetry)
+                    {
+                        JoystickSample sample;
+                        sample.set(joystick.joystick_id(), joystick.timestamp(), joystick.axes_count(), joystick.axes(),
+                                   joystick.button_count(), joystick.buttons());
+                        if (recorder)
+                            recorder->record(sample);
+                        export_telemetry(telemetry, sample, *widgets[i]);
+                    }
+                }
+            }
+        }
+
+        const BenchClock::time_point begin = BenchClock::now();
+        {
+            ScopedFrameTimer timer(profiler, FrameMetric_Build);
+            context.new_frame();
+            for (auto& widget : widgets)
+                widget->draw();
+            events.draw("Joystick events");
+        }
+        ImDrawData* draw_data = NULL;
+        {
+            ScopedFrameTimer timer(profiler, FrameMetric_Render);
+            draw_data = context.render();
+        }
+        profiler.end_frame(now_seconds());
+        frame_allocations.end_frame();
+        if (measured)
+        {
+            frame_ns += elapsed_ns(begin, BenchClock::now());
+            vertices += draw_data->TotalVtxCount;
+            if (draw_data->TotalVtxCount > result.max_vertices)
+                result.max_vertices = draw_data->TotalVtxCount;
+        }
+    }
+
+    sampler.stop();
+
+    const double frames = options.frames;
+    result.updates_per_frame = updates / frames;
+    result.ns_per_update = updates ? static_cast<double>(update_ns) / updates : 0.0;
+    result.ns_per_frame = frame_ns / frames;
+    result.vertices_per_frame = vertices / frames;
+    result.allocs_per_frame = (allocation_counter::count() - allocs_begin) / frames;
+    result.alloc_bytes_per_frame = (allocation_counter::bytes() - alloc_bytes_begin) / frames;
+    result.allocating_frames = frame_allocations.allocating_frames();
+    result.frame = profiler.stats(FrameMetric_Frame);
+    result.input_age = profiler.stats(FrameMetric_InputAge);
+    return result;
+}
+
+// Replays `replay` a second time, after rewind(), and compares every sample against a fresh SessionReplay of the same
+// file. Both must decode the same, no state may leak from one replay into the next.
+static bool check_replay_twice(const char* path, SessionReplay& replay)
+{
+    SessionReplay reference;
+    if (!reference.open_file(path))
+        return false;
+
+    replay.rewind();
+    JoystickSample first, second;
+    int64_t index = 0;
+    for (;; ++index)
+    {
+        const bool decoded = reference.next(first);
+        if (decoded != replay.next(second))
+            break;
+        if (!decoded)
+            return true;
+        if (first.joystick_id != second.joystick_id || first.timestamp != second.timestamp ||
+            first.axes_count != second.axes_count || first.button_count != second.button_count ||
+            std::memcmp(first.axes, second.axes, sizeof(first.axes)) != 0 ||
+            std::memcmp(first.buttons, second.buttons, sizeof(first.buttons)) != 0)
+            break;
+    }
+    fprintf(stderr, "Replaying '%s' a second time differs from the first time at sample %lld\n", path,
+            (long long)index);
+    return false;
+}
+
+// Plays a recording back at maximum speed. Samples are fed to the widgets in the order they were recorded, with a
+// frame drawn for every 1/60 s of recorded time.
+static int run_replay(const char* path, TelemetryExporter* telemetry)
+{
+    SessionReplay replay;
+    if (!replay.open_file(path))
+    {
+        fprintf(stderr, "Can't open recording '%s'\n", path);
+        return 1;
+    }
+
+    HeadlessContext context;
+    JoystickEventLog events;
+    std::unique_ptr<JoystickWidget> widgets[session_recording::MaxDevices];
+
+    const double frame_period = 1.0 / 60.0;
+    double next_frame = frame_period;
+    int64_t decode_ns = 0;
+    int64_t update_ns = 0;
+    int64_t frame_ns = 0;
+    int64_t samples = 0;
+    int64_t frames = 0;
+
+    JoystickSample sample;
+    for (;;)
+    {
+        BenchClock::time_point begin = BenchClock::now();
+        const bool decoded = replay.next(sample);
+        BenchClock::time_point end = BenchClock::now();
+        decode_ns += elapsed_ns(begin, end);
+
+        if (!decoded || sample.timestamp >= next_frame)
+        {
+            begin = end;
+            context.new_frame();
+            for (auto& widget : widgets)
+            {
+                if (widget)
+                    widget->draw();
+            }
+            events.draw("Joystick events");
+            context.render();
+            frame_ns += elapsed_ns(begin, BenchClock::now());
+            ++frames;
+            while (next_frame <= sample.timestamp)
+                next_frame += frame_period;
+        }
+        if (!decoded)
+            break;
+
+        std::unique_ptr<JoystickWidget>& widget = widgets[sample.joystick_id];
+        if (!widget)
+        {
+            widget.reset(new JoystickWidget("Joystick widget " + std::to_string(sample.joystick_id)));
+            widget->set_event_log(&events);
+            widget->set_device(sample.joystick_id, ("Replay " + std::to_string(sample.joystick_id)).c_str());
+        }
+
+        begin = BenchClock::now();
+        widget->update(sample);
+        update_ns += elapsed_ns(begin, BenchClock::now());
+        ++samples;
+        export_telemetry(telemetry, sample, *widget);
+    }
+
+    if (replay.failed())
+        fprintf(stderr, "Recording '%s' is truncated or corrupt, replayed the first %lld samples\n", path,
+                (long long)samples);
+
+    printf("%-14s %10s %12s %12s %12s %10s %12s\n",
+           "replay", "samples", "seconds", "ns/decode", "ns/update", "frames", "ns/frame");
+    printf("%-14s %10lld %12.1f %12.1f %12.1f %10lld %12.1f\n",
+           "", (long long)samples, sample.timestamp,
+           samples ? static_cast<double>(decode_ns) / samples : 0.0,
+           samples ? static_cast<double>(update_ns) / samples : 0.0,
+           (long long)frames, frames ? static_cast<double>(frame_ns) / frames : 0.0);
+    if (replay.failed())
+        return 1;
+    return check_replay_twice(path, replay) ? 0 : 1;
+}
+
+// Filters options.frames frames worth of 16 devices x 1 kHz input per smoothing mode. The input is generated up front
+// and copied into the batch before every run, only AxisFilterPipeline::process() is timed.
+static int run_filter_bench(const BenchOptions& options)
+{
+    const int devices = 16;
+    const int axes_count = 6;
+    const double sample_rate = 1000.0;
+    const int steps_per_frame = static_cast<int>(sample_rate / 60.0 + 0.5);
+    const int batch_size = devices * steps_per_frame;
+
+    std::vector<SyntheticJoystick> joysticks;
+    for (int i = 0; i < devices; ++i)
+        joysticks.emplace_back(i, axes_count, 18, SyntheticJoystick::Pattern_Sticks | SyntheticJoystick::Pattern_Noise);
+
+    // One second of input, reused with shifted timestamps so the smoothing sees time going on.
+    const int input_frames = 60;
+    std::vector<JoystickSample> input(static_cast<size_t>(input_frames) * batch_size);
+    for (int step = 0; step < input_frames * steps_per_frame; ++step)
+    {
+        for (SyntheticJoystick& joystick : joysticks)
+        {
+            joystick.step(step);
+            input[static_cast<size_t>(step) * devices + joystick.joystick_id()].set(
+                joystick.joystick_id(), step / sample_rate, joystick.axes_count(), joystick.axes(),
+                joystick.button_count(), joystick.buttons());
+        }
+    }
+    std::vector<JoystickSample> batch(batch_size);
+
+    struct FilterSetup
+    {
+        const char* name;
+        bool shaped; // Calibration, radial and axial deadzones and a response curve, or only the clamping.
+        AxisSmoothing smoothing;
+    };
+    static const FilterSetup setups[] = {
+        { "clamp only", false, AxisSmoothing_None },
+        { "shaped",     true,  AxisSmoothing_None },
+        { "low-pass",   true,  AxisSmoothing_LowPass },
+        { "one-euro",   true,  AxisSmoothing_OneEuro },
+        { "kalman",     true,  AxisSmoothing_Kalman },
+    };
+
+    printf("%-14s %4s %4s %8s %12s %12s %12s %10s\n",
+           "filters", "devs", "axes", "rate", "samples", "ns/sample", "ns/frame", "cpu %");
+    float checksum = 0.f;
+    for (const FilterSetup& setup : setups)
+    {
+        AxisFilterPipeline pipeline;
+        for (int d = 0; d < devices; ++d)
+        {
+            AxisFilterConfig& config = pipeline.config(d);
+            config.smoothing = setup.smoothing;
+            if (!setup.shaped)
+                continue;
+            for (int i = 0; i < axes_count; ++i)
+            {
+                config.center[i] = 0.01f;
+                config.scale[i] = 1.02f;
+                config.deadzone[i] = 0.05f;
+                config.exponent[i] = 1.5f;
+            }
+            config.stick_count = 2;
+            config.stick_x[0] = 0;
+            config.stick_y[0] = 1;
+            config.stick_x[1] = 2;
+            config.stick_y[1] = 3;
+            config.radial_deadzone[0] = config.radial_deadzone[1] = 0.1f;
+        }
+
+        int64_t process_ns = 0;
+        int64_t samples = 0;
+        const int total_frames = options.warmup + options.frames;
+        for (int frame = 0; frame < total_frames; ++frame)
+        {
+            const JoystickSample* source = &input[static_cast<size_t>(frame % input_frames) * batch_size];
+            const double time_offset = (frame / input_frames) * 1.0;
+            for (int i = 0; i < batch_size; ++i)
+            {
+                batch[i] = source[i];
+                batch[i].timestamp += time_offset;
+            }
+
+            const BenchClock::time_point begin = BenchClock::now();
+            pipeline.process(batch.data(), batch_size);
+            const int64_t ns = elapsed_ns(begin, BenchClock::now());
+            if (frame >= options.warmup)
+            {
+                process_ns += ns;
+                samples += batch_size;
+            }
+            checksum += batch[batch_size - 1].axes[0];
+        }
+
+        const double ns_per_sample = samples ? static_cast<double>(process_ns) / samples : 0.0;
+        printf("%-14s %4d %4d %8.0f %12lld %12.1f %12.1f %9.3f%%\n", setup.name, devices, axes_count, sample_rate,
+               (long long)samples, ns_per_sample, static_cast<double>(process_ns) / options.frames,
+               ns_per_sample * devices * sample_rate * 1e-9 * 100.0);
+    }
+    // Keeps the results alive, the compiler can't drop the work.
+    printf("checksum %.3f\n", checksum);
+    return 0;
+}
+
+// Stops the exporter, which sends what is still queued, and prints what went out.
+static float distance_to_segment(const ImVec2& a, const ImVec2& b, const ImVec2& p)
+{
+    const float dx = b.x - a.x;
+    const float dy = b.y - a.y;
+    const float length_squared = dx * dx + dy * dy;
+    float t = length_squared > 0.f ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / length_squared : 0.f;
+    t = t < 0.f ? 0.f : (t > 1.f ? 1.f : t);
+    return std::hypot(a.x + t * dx - p.x, a.y + t * dy - p.y);
+}
+
+// Simplifies a Lissajous trace with up to +-2 tolerance jitter at several sampling rates and measures how far each
+// input point is from the segment of the simplified path it was folded into.
+static int check_simplifier()
+{
+    const float tolerance = 0.005f;
+    const double pi = 3.14159265358979323846;
+    const int steps_list[] = { 500, 2000, 20000 };
+    const float jitter_list[] = { 0.f, 0.5f * tolerance, 2.f * tolerance };
+
+    float worst = 0.f;
+    printf("%-14s %10s %10s %10s %12s\n", "simplifier", "points", "jitter", "vertices", "max error");
+    for (int steps : steps_list)
+    {
+        for (float jitter : jitter_list)
+        {
+            PolylineSimplifier simplifier(tolerance);
+            std::vector<ImVec2> pending;
+            ImVec2 previous, vertex;
+            float error = 0.f;
+            uint32_t seed = 1;
+            for (int i = 0; i <= steps; ++i)
+            {
+                const double t = 2.0 * pi * i / steps;
+                seed = seed * 1664525u + 1013904223u;
+                const float jx = jitter * ((seed >> 8) / 16777216.f - 0.5f);
+                seed = seed * 1664525u + 1013904223u;
+                const float jy = jitter * ((seed >> 8) / 16777216.f - 0.5f);
+                const ImVec2 point(static_cast<float>(0.8 * std::sin(3.0 * t)) + jx,
+                                   static_cast<float>(0.8 * std::sin(4.0 * t + 0.5)) + jy);
+
+                // A new vertex closes the segment the pending points were folded into, `point` starts the next one.
+                if (simplifier.add(point, vertex))
+                {
+                    for (const ImVec2& p : pending)
+                        error = std::max(error, distance_to_segment(previous, vertex, p));
+                    pending.clear();
+                    previous = vertex;
+                    if (i == 0)
+                        continue;
+                }
+                pending.push_back(point);
+            }
+            const ImVec2 end = simplifier.has_tail() ? simplifier.tail() : previous;
+            for (const ImVec2& p : pending)
+                error = std::max(error, distance_to_segment(previous, end, p));
+
+            printf("%-14s %10d %10.4f %10llu %12.5f\n", "", steps + 1, jitter,
+                   (unsigned long long)simplifier.output_count() + (simplifier.has_tail() ? 1 : 0), error);
+            worst = std::max(worst, error);
+        }
+    }
+
+    // Slack for the float rounding of the two distance computations.
+    if (worst > tolerance * 1.0001f)
+    {
+        fprintf(stderr, "Simplified path is %.5f away from its input, more than the %.5f tolerance\n", worst, tolerance);
+        return 1;
+    }
+    return 0;
+}
+
+static void print_telemetry(TelemetryExporter* telemetry)
+{
+    if (!telemetry)
+        return;
+    telemetry->stop();
+    printf("telemetry: %llu records in %llu packets, %llu bytes, %llu records dropped, %llu packets not sent\n",
+           (unsigned long long)telemetry->records_sent(), (unsigned long long)telemetry->packets_sent(),
+           (unsigned long long)telemetry->bytes_sent(), (unsigned long long)telemetry->dropped(),
+           (unsigned long long)telemetry->send_errors());
+}
+
+// Peaks of different subsystems may come from different moments, the total is the real peak. Native 64-bit builds
+// need somewhat more than wasm32 for the same data.
+static void print_memory()
+{
+    printf("peak heap:");
+    for (int tag = 0; tag < MemoryTag_Count; ++tag)
+        printf(" %s %.1f KiB,", memory_tag_name(tag), allocation_counter::peak_bytes(tag) / 1024.0);
+    printf(" total %.1f KiB\n", allocation_counter::peak_bytes() / 1024.0);
+}
+
+static bool parse_options(int argc, char** argv, BenchOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--frames") == 0 && has_value)
+            options.frames = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--warmup") == 0 && has_value)
+            options.warmup = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--scenario") == 0 && has_value)
+            options.scenario = argv[++i];
+        else if (std::strcmp(argv[i], "--record") == 0 && has_value)
+            options.record = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0 && has_value)
+            options.replay = argv[++i];
+        else if (std::strcmp(argv[i], "--telemetry") == 0 && has_value)
+            options.telemetry = argv[++i];
+        else if (std::strcmp(argv[i], "--filters") == 0)
+            options.filters = true;
+        else if (std::strcmp(argv[i], "--simplifier") == 0)
+            options.simplifier = true;
+        else
+            return false;
+    }
+    return options.frames > 0 && options.warmup >= 0 && !(options.record && options.replay);
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    if (!parse_options(argc, argv, options))
+    {
+        fprintf(stderr, "Usage: %s [--frames N] [--warmup N] [--scenario name] [--record file | --replay file] "
+                "[--telemetry udp:host:port | unix:path] [--filters] [--simplifier]\n", argv[0]);
+        return 1;
+    }
+
+    if (options.filters)
+        return run_filter_bench(options);
+    if (options.simplifier)
+        return check_simplifier();
+
+    allocation_counter::install_imgui_allocator();
+
+    TelemetryExporter telemetry;
+    if (options.telemetry && !telemetry.start(options.telemetry))
+    {
+        fprintf(stderr, "Can't send telemetry to '%s'\n", options.telemetry);
+        return 1;
+    }
+    TelemetryExporter* telemetry_output = options.telemetry ? &telemetry : NULL;
+
+    if (options.replay)
+    {
+        const int status = run_replay(options.replay, telemetry_output);
+        print_telemetry(telemetry_output);
+        print_memory();
+        return status;
+    }
+
+    // All selected scenarios go into the same recording, one after the other.
+    SessionRecorder recorder;
+    if (options.record)
+        recorder.begin();
+
+    printf("%-14s %4s %4s %4s %10s %12s %12s %12s %12s %10s %10s %12s %14s %12s\n",
+           "scenario", "devs", "axes", "btns", "upd/frame", "ns/update", "ns/frame", "p99 frame us", "p99 age us",
+           "vtx/frame", "vtx max", "allocs/frame", "bytes/frame", "alloc frames");
+
+    bool found = false;
+    bool allocated = false;
+    for (const Scenario& scenario : g_scenarios)
+    {
+        if (options.scenario && std::strcmp(options.scenario, scenario.name) != 0)
+            continue;
+        found = true;
+
+        const BenchResult result = run_scenario(scenario, options, options.record ? &recorder : NULL, telemetry_output);
+        printf("%-14s %4d %4d %4d %10.1f %12.1f %12.1f %12.1f %12.1f %10.1f %10d %12.2f %14.1f %12llu\n",
+               scenario.name, scenario.devices, scenario.axes_count, scenario.button_count,
+               result.updates_per_frame, result.ns_per_update, result.ns_per_frame, result.frame.p99 * 1e6,
+               result.input_age.p99 * 1e6, result.vertices_per_frame, result.max_vertices,
+               result.allocs_per_frame, result.alloc_bytes_per_frame, (unsigned long long)result.allocating_frames);
+        allocated |= result.allocating_frames > 0;
+    }
+
+    if (!found)
+    {
+        fprintf(stderr, "Unknown scenario '%s'\n", options.scenario);
+        return 1;
+    }
+    print_telemetry(telemetry_output);
+    print_memory();
+
+    if (options.record)
+    {
+        recorder.end();
+        if (!recorder.save(options.record))
+        {
+            fprintf(stderr, "Can't write recording '%s'\n", options.record);
+            return 1;
+        }
+        printf("recorded %llu samples to %s, %zu bytes (%.2f bytes/sample)\n",
+               (unsigned long long)recorder.sample_count(), options.record, recorder.data().size(),
+               recorder.sample_count() ? static_cast<double>(recorder.data().size()) / recorder.sample_count() : 0.0);
+    }
+    else if (allocated)
+    {
+        fprintf(stderr, "Steady-state frames allocated, see the alloc frames column\n");
+        return 1;
+    }
+    return 0;
+}
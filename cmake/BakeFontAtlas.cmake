@@ -0,0 +1,16 @@
+# Runs bake_font_atlas and writes its output to OUTPUT. Run by the build when JOYSTICK_BAKED_FONTS is on.
+#   cmake -DBAKER="node|bake_font_atlas.js" -DOUTPUT=BakedFontAtlasData.h -P BakeFontAtlas.cmake
+# BAKER is the |-separated command line, with the emulator in front when cross compiling.
+
+string(REPLACE "|" ";" BAKER "${BAKER}")
+
+execute_process(
+        COMMAND ${BAKER}
+        OUTPUT_FILE ${OUTPUT}.tmp
+        RESULT_VARIABLE RESULT
+        )
+if (NOT RESULT EQUAL 0)
+    file(REMOVE ${OUTPUT}.tmp)
+    message(FATAL_ERROR "Baking the font atlas failed: ${RESULT}")
+endif()
+file(RENAME ${OUTPUT}.tmp ${OUTPUT})
@@ -0,0 +1,20 @@
+# Prints the size of every file in FILES, a |-separated list. Run by the size_report target.
+#   cmake -DFILES="a|b" -P SizeReport.cmake
+
+string(REPLACE "|" ";" FILES "${FILES}")
+
+set(TOTAL 0)
+foreach(FILE ${FILES})
+    get_filename_component(NAME ${FILE} NAME)
+    if (EXISTS ${FILE})
+        file(SIZE ${FILE} SIZE)
+        math(EXPR TOTAL "${TOTAL} + ${SIZE}")
+        math(EXPR KIB "${SIZE} / 1024")
+        message("${NAME}: ${SIZE} bytes (${KIB} KiB)")
+    else()
+        message("${NAME}: missing")
+    endif()
+endforeach()
+
+math(EXPR TOTAL_KIB "${TOTAL} / 1024")
+message("total: ${TOTAL} bytes (${TOTAL_KIB} KiB)")
@@ -0,0 +1,356 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Heap allocation counting: operator new (std containers, std::string) and everything Dear ImGui/ImPlot allocate
+// through ImGui::MemAlloc(). Used to check that steady-state frames don't allocate, see FrameAllocations.
+//
+// Live and peak bytes are also kept per subsystem (MemoryTag) for the memory panel, see HeapMonitor. Allocations are
+// charged to the tag of the innermost ScopedMemoryTag on the allocating thread, ImGui::MemAlloc() outside of any to
+// MemoryTag_ImGui. Every block carries a small header with its size and tag so freeing it can be accounted for.
+//
+// Only compiled in with JOYSTICK_COUNT_ALLOCATIONS (every build but JOYSTICK_PRODUCTION), otherwise the counts stay 0.
+// The counting operator new replaces the global one (all forms of it), so exactly one translation unit of the program
+// defines ALLOCATION_COUNTER_IMPLEMENTATION before including this header. install_imgui_allocator() has to be called
+// before ImGui::CreateContext().
+enum MemoryTag
+{
+    MemoryTag_Other,
+    MemoryTag_ImGui,     // Dear ImGui and ImPlot state, fonts, draw lists.
+    MemoryTag_Plots,     // What drawing the joystick widgets allocates in ImPlot, PaintCanvas.
+    MemoryTag_History,   // SampleHistory.
+    MemoryTag_Logger,    // Log windows and JoystickEventLog.
+    MemoryTag_Recording, // SessionRecorder.
+    MemoryTag_Count
+};
+
+inline const char* memory_tag_name(int tag)
+{
+    static const char* const names[MemoryTag_Count] = { "Other", "ImGui", "Plots", "History", "Logger", "Recording" };
+    return tag >= 0 && tag < MemoryTag_Count ? names[tag] : "?";
+}
+
+namespace allocation_counter
+{
+
+// Keeps malloc()'s alignment for the block after it.
+enum { HeaderSize = 16 };
+
+struct Header
+{
+    size_t size;
+    int tag;
+};
+
+static_assert(sizeof(Header) <= HeaderSize, "The allocation header has to fit in front of the block");
+
+struct TagCounters
+{
+    std::atomic<int64_t> live;
+    std::atomic<int64_t> peak;
+};
+
+inline std::atomic<uint64_t>& count_storage()
+{
+    static std::atomic<uint64_t> count(0);
+    return count;
+}
+
+inline std::atomic<uint64_t>& bytes_storage()
+{
+    static std::atomic<uint64_t> bytes(0);
+    return bytes;
+}
+
+// Index MemoryTag_Count holds the totals.
+inline TagCounters* tag_storage()
+{
+    static TagCounters tags[MemoryTag_Count + 1];
+    return tags;
+}
+
+inline int& current_tag()
+{
+    static thread_local int tag = MemoryTag_Other;
+    return tag;
+}
+
+inline void raise_peak(std::atomic<int64_t>& peak, int64_t value)
+{
+    int64_t current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+inline void add(size_t size)
+{
+    count_storage().fetch_add(1, std::memory_order_relaxed);
+    bytes_storage().fetch_add(size, std::memory_order_relaxed);
+}
+
+inline void add_live(int tag, int64_t size)
+{
+    TagCounters* tags = tag_storage();
+    const int64_t live = tags[tag].live.fetch_add(size, std::memory_order_relaxed) + size;
+    const int64_t total = tags[MemoryTag_Count].live.fetch_add(size, std::memory_order_relaxed) + size;
+    if (size > 0)
+    {
+        raise_peak(tags[tag].peak, live);
+        raise_peak(tags[MemoryTag_Count].peak, total);
+    }
+}
+
+inline uint64_t count() { return count_storage().load(std::memory_order_relaxed); }
+inline uint64_t bytes() { return bytes_storage().load(std::memory_order_relaxed); }
+
+// Bytes allocated and not freed yet, and the most there ever were, per MemoryTag or (MemoryTag_Count) in total.
+inline int64_t live_bytes(int tag = MemoryTag_Count) { return tag_storage()[tag].live.load(std::memory_order_relaxed); }
+inline int64_t peak_bytes(int tag = MemoryTag_Count) { return tag_storage()[tag].peak.load(std::memory_order_relaxed); }
+
+inline void reset_peaks()
+{
+    for (int i = 0; i <= MemoryTag_Count; ++i)
+        tag_storage()[i].peak.store(live_bytes(i), std::memory_order_relaxed);
+}
+
+inline void* tracked_malloc(size_t size, int tag)
+{
+    unsigned char* block = static_cast<unsigned char*>(std::malloc(size + HeaderSize));
+    if (!block)
+        return NULL;
+    Header* header = reinterpret_cast<Header*>(block);
+    header->size = size;
+    header->tag = tag;
+    add(size);
+    add_live(tag, static_cast<int64_t>(size));
+    return block + HeaderSize;
+}
+
+inline void tracked_free(void* ptr)
+{
+    if (!ptr)
+        return;
+    unsigned char* block = static_cast<unsigned char*>(ptr) - HeaderSize;
+    const Header* header = reinterpret_cast<const Header*>(block);
+    add_live(header->tag, -static_cast<int64_t>(header->size));
+    std::free(block);
+}
+
+inline bool enabled()
+{
+#ifdef JOYSTICK_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+inline void* imgui_alloc(size_t size, void*)
+{
+    const int tag = current_tag();
+    return tracked_malloc(size, tag == MemoryTag_Other ? static_cast<int>(MemoryTag_ImGui) : tag);
+}
+
+inline void imgui_free(void* ptr, void*)
+{
+    tracked_free(ptr);
+}
+
+inline void install_imgui_allocator()
+{
+#ifdef JOYSTICK_COUNT_ALLOCATIONS
+    ImGui::SetAllocatorFunctions(imgui_alloc, imgui_free);
+#endif
+}
+
+} // namespace allocation_counter
+
+// Charges the allocations of the current thread to `tag` for the lifetime of the scope. Free without
+// JOYSTICK_COUNT_ALLOCATIONS.
+class ScopedMemoryTag
+{
+public:
+#ifdef JOYSTICK_COUNT_ALLOCATIONS
+    explicit ScopedMemoryTag(MemoryTag tag)
+        : m_previous(allocation_counter::current_tag())
+    {
+        allocation_counter::current_tag() = tag;
+    }
+
+    ~ScopedMemoryTag()
+    {
+        allocation_counter::current_tag() = m_previous;
+    }
+
+private:
+    int m_previous;
+#else
+    explicit ScopedMemoryTag(MemoryTag) {}
+#endif
+
+    ScopedMemoryTag(const ScopedMemoryTag&) = delete;
+    ScopedMemoryTag& operator=(const ScopedMemoryTag&) = delete;
+};
+
+#if defined(JOYSTICK_COUNT_ALLOCATIONS) && defined(ALLOCATION_COUNTER_IMPLEMENTATION)
+
+void* operator new(std::size_t size)
+{
+    if (void* ptr = allocation_counter::tracked_malloc(size, allocation_counter::current_tag()))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    allocation_counter::tracked_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    allocation_counter::tracked_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    allocation_counter::tracked_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    allocation_counter::tracked_free(ptr);
+}
+
+// The nothrow forms have to go through the header too. The default ones would malloc() a block without one that the
+// replaced operator delete then frees 16 bytes early (Emscripten's libc++ without exceptions does exactly that, e.g.
+// std::get_temporary_buffer() in std::stable_sort()).
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocation_counter::tracked_malloc(size, allocation_counter::current_tag());
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocation_counter::tracked_malloc(size, allocation_counter::current_tag());
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    allocation_counter::tracked_free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    allocation_counter::tracked_free(ptr);
+}
+
+#endif
+
+// Allocations per frame. After a warm-up, during which ImGui and ImPlot size their buffers, every frame should do
+// zero allocations; frames that do are counted and, in strict mode, asserted on.
+//
+// Things that legitimately allocate (a device connecting, a window opening for the first time) call rearm() to start
+// another warm-up.
+class FrameAllocations
+{
+public:
+    explicit FrameAllocations(int warmup_frames = 120)
+        : m_warmupFrames(warmup_frames), m_warmup(warmup_frames)
+    {
+    }
+
+    // Call once per presented frame, counts everything allocated since the previous call.
+    void end_frame()
+    {
+        const uint64_t count = allocation_counter::count();
+        const uint64_t bytes = allocation_counter::bytes();
+        m_lastFrame = count - m_count;
+        m_lastFrameBytes = bytes - m_bytes;
+        m_count = count;
+        m_bytes = bytes;
+
+        if (m_warmup > 0)
+        {
+            --m_warmup;
+            return;
+        }
+
+        ++m_steadyFrames;
+        if (m_lastFrame == 0)
+            return;
+
+        ++m_allocatingFrames;
+        m_steadyAllocations += m_lastFrame;
+        if (m_lastFrame > m_maxPerFrame)
+            m_maxPerFrame = m_lastFrame;
+        IM_ASSERT(!m_strict && "Steady-state frame allocated");
+    }
+
+    void rearm() { m_warmup = m_warmupFrames; }
+
+    void reset()
+    {
+        rearm();
+        m_steadyFrames = 0;
+        m_allocatingFrames = 0;
+        m_steadyAllocations = 0;
+        m_maxPerFrame = 0;
+    }
+
+    void set_strict(bool strict) { m_strict = strict; }
+    bool strict() const { return m_strict; }
+
+    bool warming_up() const { return m_warmup > 0; }
+    uint64_t last_frame() const { return m_lastFrame; }
+    uint64_t last_frame_bytes() const { return m_lastFrameBytes; }
+    uint64_t steady_frames() const { return m_steadyFrames; }
+    uint64_t allocating_frames() const { return m_allocatingFrames; }
+    uint64_t steady_allocations() const { return m_steadyAllocations; }
+    uint64_t max_per_frame() const { return m_maxPerFrame; }
+
+    void draw()
+    {
+        if (!allocation_counter::enabled())
+        {
+            ImGui::TextDisabled("Allocation counting is not compiled in");
+            return;
+        }
+
+        ImGui::Text("%llu allocations total, %llu last frame (%llu bytes)%s",
+                    (unsigned long long)allocation_counter::count(), (unsigned long long)m_lastFrame,
+                    (unsigned long long)m_lastFrameBytes, warming_up() ? ", warming up" : "");
+        ImGui::Text("%llu of %llu steady frames allocated, %llu allocations, at most %llu per frame",
+                    (unsigned long long)m_allocatingFrames, (unsigned long long)m_steadyFrames,
+                    (unsigned long long)m_steadyAllocations, (unsigned long long)m_maxPerFrame);
+        ImGui::Checkbox("Assert on steady-state allocations", &m_strict);
+        ImGui::SameLine();
+        if (ImGui::Button("Reset"))
+            reset();
+    }
+
+private:
+    int m_warmupFrames;
+    int m_warmup;
+    bool m_strict = false;
+
+    uint64_t m_count = allocation_counter::count();
+    uint64_t m_bytes = allocation_counter::bytes();
+    uint64_t m_lastFrame = 0;
+    uint64_t m_lastFrameBytes = 0;
+
+    uint64_t m_steadyFrames = 0;
+    uint64_t m_allocatingFrames = 0;
+    uint64_t m_steadyAllocations = 0;
+    uint64_t m_maxPerFrame = 0;
+};
@@ -0,0 +1,377 @@
+#pragma once
+
+#include "JoystickSample.h"
+
+#include "imgui.h"
+
+#include <cmath>
+#include <cstdio>
+
+// Per-axis signal processing between the input source and JoystickWidget:
+//   calibration   value = (raw - center) * scale, clamped to [-1, 1]
+//   smoothing     one of low-pass, one-euro or Kalman, per device, with per-axis parameters
+//   radial        deadzone of stick pairs (x, y) on the stick's magnitude, keeps the direction
+//   axial         deadzone per axis
+//   curve         response curve sign(v) * |v|^exponent
+// Deadzones rescale what is outside of them, so the output still reaches 1.
+//
+// The kernels work on one sample at a time across all MaxAxes lanes, with per-axis parameter arrays and no branches
+// per lane, plain loops the compiler vectorises at -O3 (SSE2, NEON, wasm SIMD128 with -msimd128). Smoothing is a
+// recurrence over time, so lanes are the only dimension it can be vectorised over. The response curve needs pow(),
+// which doesn't vectorise, and is skipped for devices without one. The default configuration only clamps.
+enum AxisSmoothing
+{
+    AxisSmoothing_None,
+    AxisSmoothing_LowPass,
+    AxisSmoothing_OneEuro,
+    AxisSmoothing_Kalman,
+    AxisSmoothing_Count,
+};
+
+struct AxisFilterConfig
+{
+    enum { MaxAxes = JoystickSample::MaxAxes, MaxSticks = 4 };
+
+    alignas(16) float center[MaxAxes];
+    alignas(16) float scale[MaxAxes];
+    alignas(16) float deadzone[MaxAxes];
+    alignas(16) float exponent[MaxAxes];
+
+    // Stick pairs for the radial deadzone, e.g. { 0, 1 } and { 2, 3 } for most gamepads under GLFW.
+    int stick_count = 0;
+    int stick_x[MaxSticks] = {};
+    int stick_y[MaxSticks] = {};
+    float radial_deadzone[MaxSticks] = {};
+
+    AxisSmoothing smoothing = AxisSmoothing_None;
+    // Low-pass cutoff, one-euro minimum cutoff, in Hz.
+    alignas(16) float cutoff[MaxAxes];
+    // One-euro: how fast the cutoff rises with the speed of the axis, and the cutoff used for that speed.
+    alignas(16) float beta[MaxAxes];
+    float derivative_cutoff = 1.f;
+    // Kalman: variance the true value gains per second, and the variance of the measurements.
+    alignas(16) float process_noise[MaxAxes];
+    alignas(16) float measurement_noise[MaxAxes];
+
+    AxisFilterConfig()
+    {
+        for (int i = 0; i < MaxAxes; ++i)
+        {
+            center[i] = 0.f;
+            scale[i] = 1.f;
+            deadzone[i] = 0.f;
+            exponent[i] = 1.f;
+            cutoff[i] = 10.f;
+            beta[i] = 0.05f;
+            process_noise[i] = 1.f;
+            measurement_noise[i] = 1e-3f;
+        }
+    }
+
+    bool has_curve() const
+    {
+        for (int i = 0; i < MaxAxes; ++i)
+        {
+            if (exponent[i] != 1.f)
+                return true;
+        }
+        return false;
+    }
+};
+
+// Filter state of one device.
+struct AxisFilterState
+{
+    bool initialized = false;
+    double last_timestamp = 0;
+    alignas(16) float value[AxisFilterConfig::MaxAxes] = {};      // Smoothed value, Kalman estimate.
+    alignas(16) float derivative[AxisFilterConfig::MaxAxes] = {}; // One-euro: smoothed speed. Kalman: variance.
+};
+
+namespace axis_filters
+{
+
+enum { Lanes = AxisFilterConfig::MaxAxes };
+
+// Smoothing factor of a one-pole low-pass with the given cutoff (> 0) for a step of dt seconds,
+// dt / (dt + tau) with tau = 1 / (2 pi cutoff), without dividing by the cutoff.
+inline float low_pass_alpha(float dt, float cutoff)
+{
+    const float x = 6.2831853f * cutoff * dt;
+    return x / (x + 1.f);
+}
+
+// Filter states decaying towards a resting 0 would end up as denormals, which are slow on most CPUs and can get stuck
+// there with rounding.
+inline float flush_denormal(float value)
+{
+    return std::fabs(value) < 1e-30f ? 0.f : value;
+}
+
+inline void calibrate(float* values, const float* center, const float* scale)
+{
+    for (int i = 0; i < Lanes; ++i)
+    {
+        const float v = (values[i] - center[i]) * scale[i];
+        values[i] = v < -1.f ? -1.f : (v > 1.f ? 1.f : v);
+    }
+}
+
+inline void low_pass(float* values, float* state, const float* cutoff, float dt)
+{
+    for (int i = 0; i < Lanes; ++i)
+    {
+        state[i] = flush_denormal(state[i] + low_pass_alpha(dt, cutoff[i]) * (values[i] - state[i]));
+        values[i] = state[i];
+    }
+}
+
+// One-euro filter (Casiez et al.): a low-pass whose cutoff rises with the speed of the signal, smooth at rest and
+// responsive when moving.
+inline void one_euro(float* values, float* state, float* speed, const float* min_cutoff, const float* beta,
+                     float derivative_cutoff, float dt)
+{
+    const float derivative_alpha = low_pass_alpha(dt, derivative_cutoff);
+    for (int i = 0; i < Lanes; ++i)
+    {
+        const float raw_speed = (values[i] - state[i]) / dt;
+        speed[i] = flush_denormal(speed[i] + derivative_alpha * (raw_speed - speed[i]));
+        const float cutoff = min_cutoff[i] + beta[i] * std::fabs(speed[i]);
+        state[i] = flush_denormal(state[i] + low_pass_alpha(dt, cutoff) * (values[i] - state[i]));
+        values[i] = state[i];
+    }
+}
+
+// Scalar Kalman filter with a random walk model, per lane.
+inline void kalman(float* values, float* estimate, float* variance, const float* process_noise,
+                   const float* measurement_noise, float dt)
+{
+    for (int i = 0; i < Lanes; ++i)
+    {
+        const float predicted = variance[i] + process_noise[i] * dt;
+        const float gain = predicted / (predicted + measurement_noise[i]);
+        estimate[i] = flush_denormal(estimate[i] + gain * (values[i] - estimate[i]));
+        variance[i] = (1.f - gain) * predicted;
+        values[i] = estimate[i];
+    }
+}
+
+inline void radial_deadzone(float* values, int x, int y, float deadzone)
+{
+    const float magnitude = std::sqrt(values[x] * values[x] + values[y] * values[y]);
+    const float scale = magnitude > deadzone ? (magnitude - deadzone) / ((1.f - deadzone) * magnitude) : 0.f;
+    const float vx = values[x] * scale;
+    const float vy = values[y] * scale;
+    values[x] = vx < -1.f ? -1.f : (vx > 1.f ? 1.f : vx);
+    values[y] = vy < -1.f ? -1.f : (vy > 1.f ? 1.f : vy);
+}
+
+inline void axial_deadzone(float* values, const float* deadzone)
+{
+    for (int i = 0; i < Lanes; ++i)
+    {
+        const float outside = std::fabs(values[i]) - deadzone[i];
+        values[i] = std::copysign((outside > 0.f ? outside : 0.f) / (1.f - deadzone[i]), values[i]);
+    }
+}
+
+// pow() doesn't vectorise, only the axes the device has are done.
+inline void response_curve(float* values, const float* exponent, int count)
+{
+    for (int i = 0; i < count; ++i)
+        values[i] = std::copysign(std::pow(std::fabs(values[i]), exponent[i]), values[i]);
+}
+
+} // namespace axis_filters
+
+// One AxisFilterConfig and AxisFilterState per device slot. process() filters batches of samples in place, in the
+// order they were taken; samples of different devices may be interleaved.
+class AxisFilterPipeline
+{
+public:
+    enum { MaxDevices = 16 };
+
+    AxisFilterConfig& config(int joystick_id) { return m_configs[joystick_id]; }
+    const AxisFilterConfig& config(int joystick_id) const { return m_configs[joystick_id]; }
+
+    // Forgets the filter state, e.g. when samples stop being continuous (replay, reconnect).
+    void reset()
+    {
+        for (AxisFilterState& state : m_states)
+            state = AxisFilterState();
+    }
+
+    void reset(int joystick_id)
+    {
+        m_states[joystick_id] = AxisFilterState();
+    }
+
+    void set_enabled(bool enabled) { m_enabled = enabled; }
+    bool enabled() const { return m_enabled; }
+
+    void process(JoystickSample* samples, int count)
+    {
+        if (!m_enabled || count <= 0)
+            return;
+
+        // Derived per batch, the configuration may change between batches.
+        bool curves[MaxDevices];
+        for (int i = 0; i < MaxDevices; ++i)
+            curves[i] = m_configs[i].has_curve();
+
+        for (int s = 0; s < count; ++s)
+        {
+            JoystickSample& sample = samples[s];
+            if (sample.joystick_id < 0 || sample.joystick_id >= MaxDevices)
+                continue;
+            process(sample, m_configs[sample.joystick_id], m_states[sample.joystick_id], curves[sample.joystick_id]);
+        }
+    }
+
+    // Configuration UI for one device.
+    void draw(int joystick_id, int axes_count)
+    {
+        AxisFilterConfig& config = m_configs[joystick_id];
+        ImGui::PushID(joystick_id);
+
+        static const char* const smoothing_names[AxisSmoothing_Count] = { "None", "Low-pass", "One-euro", "Kalman" };
+        int smoothing = config.smoothing;
+        if (ImGui::Combo("Smoothing", &smoothing, smoothing_names, AxisSmoothing_Count))
+        {
+            config.smoothing = static_cast<AxisSmoothing>(smoothing);
+            reset(joystick_id);
+        }
+        if (config.smoothing == AxisSmoothing_OneEuro)
+            ImGui::SliderFloat("Speed cutoff (Hz)", &config.derivative_cutoff, 0.1f, 10.f, "%.1f");
+
+        const int columns = config.smoothing == AxisSmoothing_None ? 5
+                            : (config.smoothing == AxisSmoothing_LowPass ? 6 : 7);
+        if (ImGui::BeginTable("axis_filters", columns, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Axis");
+            ImGui::TableSetupColumn("Center");
+            ImGui::TableSetupColumn("Scale");
+            ImGui::TableSetupColumn("Deadzone");
+            ImGui::TableSetupColumn("Exponent");
+            if (config.smoothing == AxisSmoothing_LowPass || config.smoothing == AxisSmoothing_OneEuro)
+                ImGui::TableSetupColumn("Cutoff (Hz)");
+            if (config.smoothing == AxisSmoothing_OneEuro)
+                ImGui::TableSetupColumn("Beta");
+            if (config.smoothing == AxisSmoothing_Kalman)
+            {
+                ImGui::TableSetupColumn("Process noise");
+                ImGui::TableSetupColumn("Measurement noise");
+            }
+            ImGui::TableHeadersRow();
+
+            const int rows = axes_count < AxisFilterConfig::MaxAxes ? axes_count
+                                                                    : static_cast<int>(AxisFilterConfig::MaxAxes);
+            for (int i = 0; i < rows; ++i)
+            {
+                ImGui::PushID(i);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", i);
+                slider_column("##center", &config.center[i], -0.5f, 0.5f, "%.3f");
+                slider_column("##scale", &config.scale[i], 0.5f, 2.f, "%.3f");
+                slider_column("##deadzone", &config.deadzone[i], 0.f, 0.9f, "%.3f");
+                slider_column("##exponent", &config.exponent[i], 0.2f, 4.f, "%.2f");
+                if (config.smoothing == AxisSmoothing_LowPass || config.smoothing == AxisSmoothing_OneEuro)
+                    slider_column("##cutoff", &config.cutoff[i], 0.1f, 100.f, "%.1f");
+                if (config.smoothing == AxisSmoothing_OneEuro)
+                    slider_column("##beta", &config.beta[i], 0.f, 1.f, "%.3f");
+                if (config.smoothing == AxisSmoothing_Kalman)
+                {
+                    slider_column("##process_noise", &config.process_noise[i], 1e-3f, 100.f, "%.3f");
+                    slider_column("##measurement_noise", &config.measurement_noise[i], 1e-6f, 1e-1f, "%.6f");
+                }
+                ImGui::PopID();
+            }
+            ImGui::EndTable();
+        }
+
+        for (int i = 0; i < config.stick_count; ++i)
+        {
+            char label[48];
+            snprintf(label, sizeof(label), "Radial deadzone, axes %d/%d", config.stick_x[i], config.stick_y[i]);
+            ImGui::SliderFloat(label, &config.radial_deadzone[i], 0.f, 0.9f, "%.3f");
+        }
+        if (config.stick_count < AxisFilterConfig::MaxSticks && axes_count >= 2 * (config.stick_count + 1) &&
+            ImGui::Button("Add stick"))
+        {
+            config.stick_x[config.stick_count] = 2 * config.stick_count;
+            config.stick_y[config.stick_count] = 2 * config.stick_count + 1;
+            config.radial_deadzone[config.stick_count] = 0.1f;
+            ++config.stick_count;
+        }
+
+        ImGui::PopID();
+    }
+
+private:
+    static void slider_column(const char* label, float* value, float min, float max, const char* format)
+    {
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(-1);
+        ImGui::SliderFloat(label, value, min, max, format);
+    }
+
+    static void process(JoystickSample& sample, const AxisFilterConfig& config, AxisFilterState& state, bool curve)
+    {
+        float* values = sample.axes;
+        axis_filters::calibrate(values, config.center, config.scale);
+
+        if (config.smoothing != AxisSmoothing_None)
+        {
+            if (!state.initialized)
+            {
+                for (int i = 0; i < axis_filters::Lanes; ++i)
+                {
+                    state.value[i] = values[i];
+                    state.derivative[i] = 0.f;
+                }
+                state.initialized = true;
+                state.last_timestamp = sample.timestamp;
+            }
+            else
+            {
+                // Events merged into one timestamp, or a clock going backwards, still count as a (short) step.
+                const double elapsed = sample.timestamp - state.last_timestamp;
+                const float dt = elapsed > 1e-5 ? static_cast<float>(elapsed) : 1e-5f;
+                state.last_timestamp = sample.timestamp;
+
+                switch (config.smoothing)
+                {
+                case AxisSmoothing_LowPass:
+                    axis_filters::low_pass(values, state.value, config.cutoff, dt);
+                    break;
+                case AxisSmoothing_OneEuro:
+                    axis_filters::one_euro(values, state.value, state.derivative, config.cutoff, config.beta,
+                                           config.derivative_cutoff, dt);
+                    break;
+                case AxisSmoothing_Kalman:
+                    axis_filters::kalman(values, state.value, state.derivative, config.process_noise,
+                                         config.measurement_noise, dt);
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+
+        for (int i = 0; i < config.stick_count; ++i)
+            axis_filters::radial_deadzone(values, config.stick_x[i], config.stick_y[i], config.radial_deadzone[i]);
+        axis_filters::axial_deadzone(values, config.deadzone);
+        if (curve)
+            axis_filters::response_curve(values, config.exponent, sample.axes_count);
+
+        // Samples are zero padded past axes_count, which the lanes above may have changed (center, curve).
+        for (int i = sample.axes_count; i < axis_filters::Lanes; ++i)
+            values[i] = 0.f;
+    }
+
+private:
+    AxisFilterConfig m_configs[MaxDevices];
+    AxisFilterState m_states[MaxDevices];
+    bool m_enabled = true;
+};
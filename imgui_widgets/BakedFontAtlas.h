@@ -0,0 +1,386 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef JOYSTICK_BAKED_FONTS
+#include "BakedFontAtlasData.h"
+#endif
+
+// Font atlas baked at build time (tools/bake_font_atlas.cpp) and embedded in the binary, so startup doesn't have to
+// rasterise the fonts. load() recreates the atlas from it as if ImFontAtlas::Build() had just run: the alpha8
+// texture, the glyphs of every font and the anti-aliased line data. The renderer backend then uploads that texture
+// as usual. Blobs of another Dear ImGui version are rejected, the caller falls back to building the atlas.
+//
+// With the JOYSTICK_BAKED_FONTS option the build generates BakedFontAtlasData.h (baked_font_atlas_data) and defines
+// JOYSTICK_BAKED_FONTS for the apps, load_or_build() picks it up.
+//
+// Blob: "JFA", byte format version, uint32 IMGUI_VERSION_NUM, uint32 payload size, then the payload PackBits
+// compressed. All integers are little-endian, floats are stored as their bits.
+// Payload:
+//   uint16 texture width, uint16 texture height, uint32 atlas flags, float x2 white pixel uv,
+//   uint16 line count, float x4 uv rect per line,
+//   uint16 font count, per font: float size, ascent, descent, uint16 fallback char, uint16 ellipsis char,
+//     uint16 dot char (0xFFFF before Dear ImGui 1.85), uint32 metrics surface, uint32 glyph count, per glyph: uint32 codepoint | colored << 30 | visible << 31,
+//     float x9 advance, x0, y0, x1, y1, u0, v0, u1, v1,
+//   texture width * height alpha bytes.
+// Fields that only exist in some Dear ImGui versions (ImFont::DotChar, ImFontAtlas::TexReady) are guarded on
+// IMGUI_VERSION_NUM.
+namespace baked_font_atlas
+{
+
+enum
+{
+    FormatVersion = 2,
+    HeaderSize = 12,
+    LineCount = IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1,
+};
+
+// PackBits: a control byte c < 128 is followed by c + 1 literal bytes, c >= 128 by one byte repeated c - 125 times.
+// Atlases are mostly runs of 0x00 and 0xFF.
+inline void compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t run = 1;
+        while (i + run < size && run < 130 && data[i + run] == data[i])
+            ++run;
+        if (run >= 3)
+        {
+            out.push_back(static_cast<uint8_t>(run + 125));
+            out.push_back(data[i]);
+            i += run;
+            continue;
+        }
+
+        // Literals up to the next run of 3.
+        size_t literals = 0;
+        while (i + literals < size && literals < 128)
+        {
+            const size_t j = i + literals;
+            if (j + 2 < size && data[j] == data[j + 1] && data[j] == data[j + 2])
+                break;
+            ++literals;
+        }
+        out.push_back(static_cast<uint8_t>(literals - 1));
+        out.insert(out.end(), data + i, data + i + literals);
+        i += literals;
+    }
+}
+
+// Returns false when the input is truncated or doesn't decompress to exactly `size` bytes.
+inline bool decompress(const uint8_t* data, size_t data_size, uint8_t* out, size_t size)
+{
+    const uint8_t* end = data + data_size;
+    size_t written = 0;
+    while (data < end)
+    {
+        const unsigned control = *data++;
+        if (control < 128)
+        {
+            const size_t count = control + 1;
+            if (static_cast<size_t>(end - data) < count || size - written < count)
+                return false;
+            std::memcpy(out + written, data, count);
+            data += count;
+            written += count;
+        }
+        else
+        {
+            const size_t count = control - 125;
+            if (data == end || size - written < count)
+                return false;
+            std::memset(out + written, *data++, count);
+            written += count;
+        }
+    }
+    return written == size;
+}
+
+class Writer
+{
+public:
+    void u16(uint32_t value)
+    {
+        m_data.push_back(static_cast<uint8_t>(value));
+        m_data.push_back(static_cast<uint8_t>(value >> 8));
+    }
+
+    void u32(uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            m_data.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void f32(float value)
+    {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        u32(bits);
+    }
+
+    void bytes(const uint8_t* data, size_t size) { m_data.insert(m_data.end(), data, data + size); }
+
+    const std::vector<uint8_t>& data() const { return m_data; }
+
+private:
+    std::vector<uint8_t> m_data;
+};
+
+class Reader
+{
+public:
+    Reader(const uint8_t* data, size_t size) : m_cursor(data), m_end(data + size) {}
+
+    uint32_t u16()
+    {
+        if (!has(2))
+            return 0;
+        const uint32_t value = m_cursor[0] | (m_cursor[1] << 8);
+        m_cursor += 2;
+        return value;
+    }
+
+    uint32_t u32()
+    {
+        if (!has(4))
+            return 0;
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+            value |= static_cast<uint32_t>(m_cursor[i]) << (8 * i);
+        m_cursor += 4;
+        return value;
+    }
+
+    float f32()
+    {
+        const uint32_t bits = u32();
+        float value = 0.f;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    const uint8_t* bytes(size_t size)
+    {
+        if (!has(size))
+            return NULL;
+        const uint8_t* data = m_cursor;
+        m_cursor += size;
+        return data;
+    }
+
+    bool failed() const { return m_error; }
+
+private:
+    bool has(size_t size)
+    {
+        m_error |= static_cast<size_t>(m_end - m_cursor) < size;
+        return !m_error;
+    }
+
+private:
+    const uint8_t* m_cursor;
+    const uint8_t* m_end;
+    bool m_error = false;
+};
+
+// Serialises a built atlas (ImFontAtlas::Build() or GetTexDataAsAlpha8() called) into a blob.
+inline std::vector<uint8_t> bake(ImFontAtlas* atlas)
+{
+    unsigned char* pixels = NULL;
+    int width = 0, height = 0;
+    atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+
+    Writer payload;
+    payload.u16(width);
+    payload.u16(height);
+    payload.u32(static_cast<uint32_t>(atlas->Flags));
+    payload.f32(atlas->TexUvWhitePixel.x);
+    payload.f32(atlas->TexUvWhitePixel.y);
+    payload.u16(LineCount);
+    for (int i = 0; i < LineCount; ++i)
+    {
+        payload.f32(atlas->TexUvLines[i].x);
+        payload.f32(atlas->TexUvLines[i].y);
+        payload.f32(atlas->TexUvLines[i].z);
+        payload.f32(atlas->TexUvLines[i].w);
+    }
+
+    payload.u16(atlas->Fonts.Size);
+    for (const ImFont* font : atlas->Fonts)
+    {
+        payload.f32(font->FontSize);
+        payload.f32(font->Ascent);
+        payload.f32(font->Descent);
+        payload.u16(font->FallbackChar);
+        payload.u16(font->EllipsisChar);
+#if IMGUI_VERSION_NUM >= 18500
+        payload.u16(font->DotChar);
+#else
+        payload.u16(0xFFFF);
+#endif
+        payload.u32(static_cast<uint32_t>(font->MetricsTotalSurface));
+        payload.u32(static_cast<uint32_t>(font->Glyphs.Size));
+        for (const ImFontGlyph& glyph : font->Glyphs)
+        {
+            payload.u32(glyph.Codepoint | (glyph.Colored << 30) | (static_cast<uint32_t>(glyph.Visible) << 31));
+            payload.f32(glyph.AdvanceX);
+            payload.f32(glyph.X0);
+            payload.f32(glyph.Y0);
+            payload.f32(glyph.X1);
+            payload.f32(glyph.Y1);
+            payload.f32(glyph.U0);
+            payload.f32(glyph.V0);
+            payload.f32(glyph.U1);
+            payload.f32(glyph.V1);
+        }
+    }
+    payload.bytes(pixels, static_cast<size_t>(width) * height);
+
+    Writer blob;
+    blob.bytes(reinterpret_cast<const uint8_t*>("JFA"), 3);
+    const uint8_t format_version = FormatVersion;
+    blob.bytes(&format_version, 1);
+    blob.u32(IMGUI_VERSION_NUM);
+    blob.u32(static_cast<uint32_t>(payload.data().size()));
+    std::vector<uint8_t> out = blob.data();
+    compress(payload.data().data(), payload.data().size(), out);
+    return out;
+}
+
+// Replaces the fonts of `atlas`, which must not be locked (between NewFrame() and EndFrame()), with the baked ones.
+// Leaves the atlas untouched and returns false when the blob is malformed or from another Dear ImGui version.
+inline bool load(ImFontAtlas* atlas, const uint8_t* blob, size_t size)
+{
+    if (size < HeaderSize || std::memcmp(blob, "JFA", 3) != 0 || blob[3] != FormatVersion)
+        return false;
+    Reader header(blob + 4, HeaderSize - 4);
+    const uint32_t version = header.u32();
+    const uint32_t payload_size = header.u32();
+    if (version != IMGUI_VERSION_NUM || payload_size == 0)
+        return false;
+
+    uint8_t* payload = static_cast<uint8_t*>(IM_ALLOC(payload_size));
+    if (!decompress(blob + HeaderSize, size - HeaderSize, payload, payload_size))
+    {
+        IM_FREE(payload);
+        return false;
+    }
+
+    // Parsed into local fonts first, the atlas only changes once everything checked out.
+    Reader reader(payload, payload_size);
+    const int width = static_cast<int>(reader.u16());
+    const int height = static_cast<int>(reader.u16());
+    const int flags = static_cast<int>(reader.u32());
+    ImVec2 white_pixel;
+    white_pixel.x = reader.f32();
+    white_pixel.y = reader.f32();
+    bool ok = reader.u16() == LineCount;
+    ImVec4 lines[LineCount];
+    for (int i = 0; ok && i < LineCount; ++i)
+    {
+        lines[i].x = reader.f32();
+        lines[i].y = reader.f32();
+        lines[i].z = reader.f32();
+        lines[i].w = reader.f32();
+    }
+
+    ImVector<ImFont*> fonts;
+    const int font_count = ok ? static_cast<int>(reader.u16()) : 0;
+    for (int f = 0; f < font_count && !reader.failed(); ++f)
+    {
+        ImFont* font = IM_NEW(ImFont);
+        fonts.push_back(font);
+        font->FontSize = reader.f32();
+        font->Ascent = reader.f32();
+        font->Descent = reader.f32();
+        font->FallbackChar = static_cast<ImWchar>(reader.u16());
+        font->EllipsisChar = static_cast<ImWchar>(reader.u16());
+        const uint32_t dot_char = reader.u16();
+#if IMGUI_VERSION_NUM >= 18500
+        font->DotChar = static_cast<ImWchar>(dot_char);
+#else
+        (void)dot_char;
+#endif
+        font->MetricsTotalSurface = static_cast<int>(reader.u32());
+        const uint32_t glyph_count = reader.u32();
+        if (glyph_count >= 0xFFFF)
+            break;
+        font->Glyphs.resize(static_cast<int>(glyph_count));
+        for (ImFontGlyph& glyph : font->Glyphs)
+        {
+            const uint32_t codepoint = reader.u32();
+            glyph.Codepoint = codepoint & 0x3FFFFFFF;
+            glyph.Colored = (codepoint >> 30) & 1;
+            glyph.Visible = (codepoint >> 31) & 1;
+            glyph.AdvanceX = reader.f32();
+            glyph.X0 = reader.f32();
+            glyph.Y0 = reader.f32();
+            glyph.X1 = reader.f32();
+            glyph.Y1 = reader.f32();
+            glyph.U0 = reader.f32();
+            glyph.V0 = reader.f32();
+            glyph.U1 = reader.f32();
+            glyph.V1 = reader.f32();
+        }
+    }
+    const size_t pixel_count = static_cast<size_t>(width) * height;
+    const uint8_t* pixels = reader.bytes(pixel_count);
+    ok = ok && !reader.failed() && pixels && fonts.Size == font_count && font_count > 0 && pixel_count > 0;
+
+    if (ok)
+    {
+        atlas->Clear();
+        atlas->Flags = flags;
+        atlas->TexWidth = width;
+        atlas->TexHeight = height;
+        atlas->TexUvScale = ImVec2(1.f / width, 1.f / height);
+        atlas->TexUvWhitePixel = white_pixel;
+        for (int i = 0; i < LineCount; ++i)
+            atlas->TexUvLines[i] = lines[i];
+        // No mouse cursor shapes in the texture, io.MouseDrawCursor falls back to the OS cursor.
+        atlas->PackIdMouseCursors = -1;
+        atlas->PackIdLines = -1;
+        atlas->TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC(pixel_count));
+        std::memcpy(atlas->TexPixelsAlpha8, pixels, pixel_count);
+#if IMGUI_VERSION_NUM >= 18300
+        // IsBuilt() checks this flag from 1.83 on, without it GetTexDataAsAlpha8() would rebuild the (config-less)
+        // atlas.
+        atlas->TexReady = true;
+#endif
+
+        // The fallback, ellipsis and dot chars are set above, BuildLookupTable() resolves the fallback glyph from them.
+        for (ImFont* font : fonts)
+        {
+            font->ContainerAtlas = atlas;
+            font->ConfigData = NULL;
+            font->ConfigDataCount = 0;
+            font->BuildLookupTable();
+            atlas->Fonts.push_back(font);
+        }
+        fonts.clear();
+    }
+
+    for (ImFont* font : fonts)
+        IM_DELETE(font);
+    IM_FREE(payload);
+    return ok;
+}
+
+// The atlas baked into this build, or built at runtime when there is none or it doesn't load. Returns whether the
+// baked one was used.
+inline bool load_or_build(ImFontAtlas* atlas)
+{
+#ifdef JOYSTICK_BAKED_FONTS
+    if (load(atlas, baked_font_atlas_data, sizeof(baked_font_atlas_data)))
+        return true;
+#endif
+    atlas->Build();
+    return false;
+}
+
+} // namespace baked_font_atlas
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <chrono>
+
+// Monotonic time in seconds shared by input sampling, history and instrumentation, so timestamps taken in different
+// places can be compared with each other. In Emscripten builds steady_clock is backed by performance.now().
+inline double now_seconds()
+{
+    using namespace std::chrono;
+    return duration_cast<duration<double>>(steady_clock::now().time_since_epoch()).count();
+}
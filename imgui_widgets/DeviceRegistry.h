@@ -0,0 +1,60 @@
+#pragma once
+
+// Set of connected joystick slots, kept up to date by connect/disconnect events rather than by probing every slot.
+// Live slots are stored densely, so iterating the registry costs nothing for empty slots.
+class DeviceRegistry
+{
+public:
+    enum { MaxDevices = 16 };
+
+    DeviceRegistry()
+    {
+        for (int& index : m_index)
+            index = -1;
+    }
+
+    bool connect(int id)
+    {
+        if (!is_valid(id) || m_index[id] >= 0)
+            return false;
+
+        m_index[id] = m_liveCount;
+        m_live[m_liveCount++] = id;
+        return true;
+    }
+
+    bool disconnect(int id)
+    {
+        if (!is_connected(id))
+            return false;
+
+        // Swap-remove, order of live devices doesn't matter.
+        const int index = m_index[id];
+        const int last = m_live[--m_liveCount];
+        m_live[index] = last;
+        m_index[last] = index;
+        m_index[id] = -1;
+        return true;
+    }
+
+    bool is_connected(int id) const
+    {
+        return is_valid(id) && m_index[id] >= 0;
+    }
+
+    static bool is_valid(int id)
+    {
+        return id >= 0 && id < MaxDevices;
+    }
+
+    int size() const { return m_liveCount; }
+    bool empty() const { return m_liveCount == 0; }
+
+    const int* begin() const { return m_live; }
+    const int* end() const { return m_live + m_liveCount; }
+
+private:
+    int m_live[MaxDevices] = {};
+    int m_index[MaxDevices];
+    int m_liveCount = 0;
+};
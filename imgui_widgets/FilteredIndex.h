@@ -0,0 +1,123 @@
+#pragma once
+
+#include "AllocationCounter.h"
+#include "Clock.h"
+
+#include <cstdint>
+#include <vector>
+
+// Cached, ordered list of the record numbers that pass a filter, for logs whose records are addressed by monotonic
+// numbers (see LogRingBuffer::first_line_number()).
+// After reset() the log is scanned in time-limited slices from its oldest record, so a big rebuild is spread over
+// several frames. Once the scan has caught up, newly appended records are tested one by one as they arrive, and
+// records evicted from the log are dropped from the front. Gives random access to the matches, so filtered views can
+// use ImGuiListClipper.
+class FilteredIndex
+{
+public:
+    explicit FilteredIndex(int capacity = 8192)
+    {
+        set_capacity(capacity);
+    }
+
+    // Capacity must be at least the number of records the log can hold. Also resets the index.
+    void set_capacity(int capacity)
+    {
+        ScopedMemoryTag tag(MemoryTag_Logger);
+        m_matches.assign(capacity > 1 ? capacity : 1, 0);
+        reset(0);
+    }
+
+    // Forgets every match and restarts the scan at `first_record`, the oldest record still in the log.
+    void reset(uint64_t first_record)
+    {
+        m_first = 0;
+        m_size = 0;
+        m_scanBegin = first_record;
+        m_cursor = first_record;
+    }
+
+    // Drops matches for records older than `first_record`, which the log has evicted.
+    void drop_before(uint64_t first_record)
+    {
+        while (m_size > 0 && m_matches[m_first] < first_record)
+        {
+            m_first = (m_first + 1) % static_cast<int>(m_matches.size());
+            --m_size;
+        }
+        if (m_cursor < first_record)
+            m_cursor = first_record;
+        if (m_scanBegin < first_record)
+            m_scanBegin = first_record;
+    }
+
+    // Continues the scan up to `end_record` (one past the newest record) for at most `budget_seconds`.
+    // `pass(record)` returns whether the record matches. Returns true once the index is up to date.
+    template<typename Predicate>
+    bool scan(uint64_t end_record, Predicate pass, double budget_seconds = 0.001)
+    {
+        const double deadline = now_seconds() + budget_seconds;
+        while (m_cursor < end_record)
+        {
+            // Checking the clock is not free, do it every few records only.
+            const uint64_t slice_end = m_cursor + 256 < end_record ? m_cursor + 256 : end_record;
+            for (; m_cursor < slice_end; ++m_cursor)
+            {
+                if (pass(m_cursor))
+                    push(m_cursor);
+            }
+            if (now_seconds() > deadline)
+                break;
+        }
+        return m_cursor >= end_record;
+    }
+
+    // Tests a freshly appended record. Ignored while a scan is still in progress, the scan will get to it.
+    template<typename Predicate>
+    void append(uint64_t record, Predicate pass)
+    {
+        if (record != m_cursor)
+            return;
+
+        if (pass(record))
+            push(record);
+        ++m_cursor;
+    }
+
+    bool is_complete(uint64_t end_record) const { return m_cursor >= end_record; }
+
+    float progress(uint64_t end_record) const
+    {
+        if (end_record <= m_scanBegin)
+            return 1.f;
+        return static_cast<float>(m_cursor - m_scanBegin) / static_cast<float>(end_record - m_scanBegin);
+    }
+
+    int size() const { return m_size; }
+
+    // Record number of the i-th match, oldest first.
+    uint64_t operator[](int i) const
+    {
+        return m_matches[(m_first + i) % m_matches.size()];
+    }
+
+private:
+    void push(uint64_t record)
+    {
+        if (m_size == static_cast<int>(m_matches.size()))
+        {
+            m_first = (m_first + 1) % static_cast<int>(m_matches.size());
+            --m_size;
+        }
+        m_matches[(m_first + m_size) % m_matches.size()] = record;
+        ++m_size;
+    }
+
+private:
+    std::vector<uint64_t> m_matches;
+    int m_first = 0;
+    int m_size = 0;
+
+    uint64_t m_scanBegin = 0; // Where the current scan started, for progress().
+    uint64_t m_cursor = 0;    // Next record to test.
+};
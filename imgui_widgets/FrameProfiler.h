@@ -0,0 +1,309 @@
+#pragma once
+
+#include "Clock.h"
+
+#include "imgui.h"
+#include "implot.h"
+
+#include <cstdint>
+
+// Fixed-size latency histogram with microsecond resolution. Buckets are log-linear: 8 linear buckets per power of
+// two, so any recorded value is off by at most 12.5%, over a range of 1 us to about 30 s. Recording is O(1) and
+// never allocates.
+class LatencyHistogram
+{
+public:
+    enum { SubBuckets = 8, Octaves = 22, BucketCount = SubBuckets * (Octaves + 1) };
+
+    void add(double seconds)
+    {
+        const double us = seconds * 1e6;
+        const uint64_t value = us > 0 ? static_cast<uint64_t>(us) : 0;
+        ++m_buckets[bucket_index(value)];
+        ++m_count;
+        m_sum += seconds;
+        if (seconds > m_max)
+            m_max = seconds;
+    }
+
+    void clear()
+    {
+        for (uint32_t& bucket : m_buckets)
+            bucket = 0;
+        m_count = 0;
+        m_sum = 0;
+        m_max = 0;
+    }
+
+    uint64_t count() const { return m_count; }
+    double max() const { return m_max; }
+    double mean() const { return m_count ? m_sum / m_count : 0.0; }
+
+    // Upper bound of the bucket holding the p-th fraction of the values, in seconds, capped at the maximum.
+    double percentile(double p) const
+    {
+        if (!m_count)
+            return 0.0;
+
+        const uint64_t rank = static_cast<uint64_t>(p * (m_count - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BucketCount; ++i)
+        {
+            seen += m_buckets[i];
+            if (seen >= rank)
+            {
+                const double upper = bucket_upper_bound(i) * 1e-6;
+                return upper < m_max ? upper : m_max;
+            }
+        }
+        return m_max;
+    }
+
+private:
+    static int log2_floor(uint64_t value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(value);
+#else
+        int log = 0;
+        while (value >>= 1)
+            ++log;
+        return log;
+#endif
+    }
+
+    static int bucket_index(uint64_t us)
+    {
+        if (us < SubBuckets)
+            return static_cast<int>(us);
+
+        // 8..15 map to 8..15, 16..31 to 16..23 in steps of 2, and so on.
+        const int log = log2_floor(us);
+        const int index = (log - 2) * SubBuckets + static_cast<int>((us >> (log - 3)) & (SubBuckets - 1));
+        return index < BucketCount ? index : BucketCount - 1;
+    }
+
+    static double bucket_upper_bound(int index)
+    {
+        if (index < SubBuckets)
+            return index + 1;
+        const int log = index / SubBuckets + 2;
+        return static_cast<double>(static_cast<uint64_t>(SubBuckets + index % SubBuckets + 1) << (log - 3));
+    }
+
+private:
+    uint32_t m_buckets[BucketCount] = {};
+    uint64_t m_count = 0;
+    double m_sum = 0;
+    double m_max = 0;
+};
+
+enum FrameMetric
+{
+    FrameMetric_PollEvents,
+    FrameMetric_Update,
+    FrameMetric_Build,
+    FrameMetric_Render,
+    FrameMetric_RenderDrawData,
+    FrameMetric_Frame,
+    // Time from sampling an input to the end of the frame that presented it, one value per sample.
+    FrameMetric_InputAge,
+    FrameMetric_Count
+};
+
+// Summary of one metric, in seconds.
+struct FrameMetricStats
+{
+    uint64_t count = 0;
+    double mean = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+// Per-stage frame timing. Stages are timed with ScopedFrameTimer (several timings of the same stage within a frame
+// add up) and folded into one LatencyHistogram per stage at end_frame(), which also keeps the last RecentFrames
+// values of each metric for plotting. Nothing allocates after construction.
+//
+// Input age is measured from the timestamp of each sample passed to add_input() to end_frame(). Inputs added in main
+// loop iterations that don't render (begin_frame() without end_frame()) stay pending until the next frame that does,
+// which is the one presenting them. In the browser the frame is only composited after main_loop returns, so the true
+// input-to-display latency is somewhat higher.
+//
+// stats() is the export hook: the overlay and the headless benchmark read the same counters through it.
+class FrameProfiler
+{
+public:
+    enum { RecentFrames = 512, MaxInputsPerFrame = 2048 };
+
+    static const char* metric_name(int metric)
+    {
+        static const char* const names[FrameMetric_Count] = {
+            "Poll events", "Update", "Build", "ImGui::Render", "Render draw data", "Frame", "Input age"
+        };
+        return metric >= 0 && metric < FrameMetric_Count ? names[metric] : "";
+    }
+
+    void begin_frame(double now)
+    {
+        m_frameStart = now;
+        for (double& value : m_current)
+            value = 0;
+    }
+
+    void record(FrameMetric metric, double seconds)
+    {
+        m_current[metric] += seconds;
+    }
+
+    void add_input(double timestamp)
+    {
+        // The oldest input sets the frame's input age, also when it didn't fit into m_inputTimestamps.
+        if (!m_hasInput || timestamp < m_oldestInput)
+            m_oldestInput = timestamp;
+        m_hasInput = true;
+
+        if (m_inputCount < MaxInputsPerFrame)
+            m_inputTimestamps[m_inputCount++] = timestamp;
+        else
+            ++m_inputOverflow;
+    }
+
+    void end_frame(double now)
+    {
+        m_current[FrameMetric_Frame] = now - m_frameStart;
+
+        for (int i = 0; i < m_inputCount; ++i)
+            m_histograms[FrameMetric_InputAge].add(now - m_inputTimestamps[i]);
+        m_current[FrameMetric_InputAge] = m_hasInput ? now - m_oldestInput : 0.0;
+        m_inputCount = 0;
+        m_hasInput = false;
+
+        for (int metric = 0; metric < FrameMetric_Count; ++metric)
+        {
+            if (metric != FrameMetric_InputAge)
+                m_histograms[metric].add(m_current[metric]);
+            m_recent[metric][m_recentOffset] = static_cast<float>(m_current[metric] * 1e3);
+        }
+        m_recentOffset = (m_recentOffset + 1) % RecentFrames;
+        if (m_recentCount < RecentFrames)
+            ++m_recentCount;
+        ++m_frames;
+    }
+
+    void reset()
+    {
+        for (LatencyHistogram& histogram : m_histograms)
+            histogram.clear();
+        m_inputOverflow = 0;
+    }
+
+    FrameMetricStats stats(FrameMetric metric) const
+    {
+        const LatencyHistogram& histogram = m_histograms[metric];
+        FrameMetricStats stats;
+        stats.count = histogram.count();
+        stats.mean = histogram.mean();
+        stats.p50 = histogram.percentile(0.50);
+        stats.p99 = histogram.percentile(0.99);
+        stats.max = histogram.max();
+        return stats;
+    }
+
+    uint64_t frames() const { return m_frames; }
+    // Inputs presented in frames that already had MaxInputsPerFrame of them, left out of the input age.
+    uint64_t input_overflow() const { return m_inputOverflow; }
+
+    void draw(const char* title)
+    {
+        if (!ImGui::Begin(title))
+        {
+            ImGui::End();
+            return;
+        }
+
+        if (ImGui::Button("Reset"))
+            reset();
+        ImGui::SameLine();
+        ImGui::Text("%llu frames", (unsigned long long)m_frames);
+
+        if (ImGui::BeginTable("frame_metrics", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Stage (ms)");
+            ImGui::TableSetupColumn("mean");
+            ImGui::TableSetupColumn("p50");
+            ImGui::TableSetupColumn("p99");
+            ImGui::TableSetupColumn("max");
+            ImGui::TableHeadersRow();
+
+            for (int metric = 0; metric < FrameMetric_Count; ++metric)
+            {
+                const FrameMetricStats stats = this->stats(static_cast<FrameMetric>(metric));
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(metric_name(metric));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.mean * 1e3);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.p50 * 1e3);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.p99 * 1e3);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", stats.max * 1e3);
+            }
+            ImGui::EndTable();
+        }
+
+        // Oldest frame first, the newest one on the right.
+        const int offset = m_recentCount < RecentFrames ? 0 : m_recentOffset;
+        ImPlot::SetNextPlotLimitsX(0, RecentFrames, ImGuiCond_Always);
+        if (ImPlot::BeginPlot("Recent frames", NULL, "ms", ImVec2(-1, 200), ImPlotFlags_None, ImPlotAxisFlags_None,
+                              ImPlotAxisFlags_AutoFit))
+        {
+            for (int metric = 0; metric < FrameMetric_Count; ++metric)
+                ImPlot::PlotLine(metric_name(metric), m_recent[metric], m_recentCount, 1.0, 0.0, offset);
+            ImPlot::EndPlot();
+        }
+
+        ImGui::End();
+    }
+
+private:
+    LatencyHistogram m_histograms[FrameMetric_Count];
+    double m_current[FrameMetric_Count] = {};
+    double m_frameStart = 0;
+    uint64_t m_frames = 0;
+
+    float m_recent[FrameMetric_Count][RecentFrames] = {};
+    int m_recentOffset = 0;
+    int m_recentCount = 0;
+
+    double m_inputTimestamps[MaxInputsPerFrame];
+    int m_inputCount = 0;
+    double m_oldestInput = 0;
+    bool m_hasInput = false;
+    uint64_t m_inputOverflow = 0;
+};
+
+// Adds the time until the end of the scope to a stage of the current frame.
+class ScopedFrameTimer
+{
+public:
+    ScopedFrameTimer(FrameProfiler& profiler, FrameMetric metric)
+        : m_profiler(profiler), m_metric(metric), m_begin(now_seconds())
+    {
+    }
+
+    ~ScopedFrameTimer()
+    {
+        m_profiler.record(m_metric, now_seconds() - m_begin);
+    }
+
+    ScopedFrameTimer(const ScopedFrameTimer&) = delete;
+    ScopedFrameTimer& operator=(const ScopedFrameTimer&) = delete;
+
+private:
+    FrameProfiler& m_profiler;
+    FrameMetric m_metric;
+    double m_begin;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "PaintCanvas.h"
+
+#if defined(__EMSCRIPTEN__)
+#include <GLES2/gl2.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#include <cstdint>
+
+// PaintTexture backed by an OpenGL texture, for the ImGui OpenGL3 renderer (ImTextureID is the GL texture name).
+// Created on the first upload, so it can be constructed before the GL context exists, but it must be destroyed while
+// the context is still current.
+//
+// WebGL 1 has no GL_UNPACK_ROW_LENGTH, so partial updates cover whole rows.
+class GlPaintTexture : public PaintTexture
+{
+public:
+    ~GlPaintTexture()
+    {
+        if (m_texture)
+            glDeleteTextures(1, &m_texture);
+    }
+
+    void upload(const uint8_t* rgba, int width, int height, int first_row, int row_count) override
+    {
+        GLint previous = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+
+        if (!m_texture || width != m_width || height != m_height)
+        {
+            if (!m_texture)
+                glGenTextures(1, &m_texture);
+            glBindTexture(GL_TEXTURE_2D, m_texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+            m_width = width;
+            m_height = height;
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, m_texture);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first_row, width, row_count, GL_RGBA, GL_UNSIGNED_BYTE,
+                            rgba + static_cast<size_t>(first_row) * width * 4);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous));
+    }
+
+    ImTextureID texture_id() const override
+    {
+        return (ImTextureID)(intptr_t)m_texture;
+    }
+
+private:
+    GLuint m_texture = 0;
+    int m_width = 0;
+    int m_height = 0;
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "DeviceRegistry.h"
+#include "InputSampler.h"
+#include "InputSource.h"
+
+#include "imgui.h"
+
+#include <GLFW/glfw3.h>
+
+static_assert(GLFW_JOYSTICK_LAST - GLFW_JOYSTICK_1 + 1 <= DeviceRegistry::MaxDevices, "Not enough device slots");
+
+// GLFW only exposes joystick state, not input events, so this source polls every connected joystick at a fixed rate
+// with an InputSampler. Hotplug comes from the GLFW joystick callback. GLFW joystick ids are used as slots directly.
+//
+// The GLFW joystick callback has no user data pointer, so there can only be one started GlfwInputSource at a time.
+class GlfwInputSource : public InputSource
+{
+public:
+    explicit GlfwInputSource(double sample_rate = 1000.0)
+        : m_sampleRate(sample_rate)
+    {
+    }
+
+    ~GlfwInputSource()
+    {
+        stop();
+    }
+
+    const char* name() const override { return "GLFW"; }
+
+    void start(InputListener* listener) override
+    {
+        m_listener = listener;
+        instance() = this;
+
+        // GLFW only reports connection changes, devices already present at startup are picked up once here.
+        glfwSetJoystickCallback(&GlfwInputSource::joystick_callback);
+        for (int i = GLFW_JOYSTICK_1; i <= GLFW_JOYSTICK_LAST; ++i)
+        {
+            if (glfwJoystickPresent(i))
+                joystick_callback(i, GLFW_CONNECTED);
+        }
+
+        m_sampler.start([this](double timestamp, JoystickSample* samples, int max_samples) {
+            return sample_joysticks(timestamp, samples, max_samples);
+        }, m_sampleRate);
+    }
+
+    void stop() override
+    {
+        m_sampler.stop();
+        if (instance() == this)
+        {
+            glfwSetJoystickCallback(NULL);
+            instance() = NULL;
+        }
+    }
+
+    int poll(JoystickSample* samples, int max_samples) override
+    {
+        return m_sampler.pop(samples, max_samples);
+    }
+
+    uint64_t dropped() const override { return m_sampler.dropped(); }
+
+    void draw_status() const override
+    {
+        ImGui::Text("GLFW, polling at %.0f Hz", m_sampler.rate());
+        ImGui::Text("%llu samples, %llu dropped", (unsigned long long)m_sampler.sampled(),
+                    (unsigned long long)m_sampler.dropped());
+    }
+
+private:
+    static void joystick_callback(int glfw_joystick_id, int event)
+    {
+        GlfwInputSource* self = instance();
+        if (!self)
+            return;
+
+        if (event == GLFW_CONNECTED)
+        {
+            if (!self->m_registry.connect(glfw_joystick_id))
+                return;
+            const char* name = glfwGetJoystickName(glfw_joystick_id);
+            self->m_listener->device_connected(glfw_joystick_id, name ? name : "");
+        }
+        else if (event == GLFW_DISCONNECTED)
+        {
+            if (self->m_registry.disconnect(glfw_joystick_id))
+                self->m_listener->device_disconnected(glfw_joystick_id);
+        }
+    }
+
+    static bool sample_joystick(int glfw_joystick_id, double timestamp, JoystickSample& sample)
+    {
+        int axes_count = 0;
+        const float *axes = glfwGetJoystickAxes(glfw_joystick_id, &axes_count);
+
+        int button_count = 0;
+        const unsigned char *buttons = glfwGetJoystickButtons(glfw_joystick_id, &button_count);
+
+        // Both return NULL if the device went away before its disconnect event was delivered.
+        if (axes == NULL || buttons == NULL)
+            return false;
+
+        sample.set(glfw_joystick_id, timestamp, axes_count, axes, button_count, buttons);
+        return true;
+    }
+
+    // InputSampler poll function, runs at the sample rate.
+    int sample_joysticks(double timestamp, JoystickSample* samples, int max_samples)
+    {
+        int count = 0;
+        for (int joystick_id : m_registry)
+        {
+            if (count < max_samples && sample_joystick(joystick_id, timestamp, samples[count]))
+                ++count;
+        }
+        return count;
+    }
+
+private:
+    // Function-local so the header doesn't need a separate definition.
+    static GlfwInputSource*& instance()
+    {
+        static GlfwInputSource* instance = NULL;
+        return instance;
+    }
+
+    double m_sampleRate;
+    InputListener* m_listener = NULL;
+    DeviceRegistry m_registry;
+    InputSampler m_sampler;
+};
+
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "AllocationCounter.h"
+
+#include "imgui.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/heap.h>
+#include <malloc.h>
+#include <unistd.h>
+#endif
+
+// Size of the wasm memory and its growth, plus the live heap per subsystem from the allocation counter.
+//
+// Growing wasm memory copies the whole heap and detaches every typed array view on it, which stalls the frame it
+// happens in. Builds are configured with an initial memory (JOYSTICK_INITIAL_MEMORY) sized for a whole session so
+// that it never happens; the panel shows how close a session gets, which initial memory would cover the peak so far,
+// and every growth that happened anyway.
+//
+// Natively there is no wasm memory, only the allocation counter's numbers are shown.
+class HeapMonitor
+{
+public:
+    enum { MaxGrowthEvents = 8 };
+
+    // Once per main loop iteration. `frame` identifies the frame a growth shows up in, for matching it with hitches.
+    void update(double now, uint64_t frame)
+    {
+        const size_t memory = current_memory_size();
+        if (m_memorySize && memory > m_memorySize)
+        {
+            GrowthEvent& event = m_growthEvents[m_growthCount % MaxGrowthEvents];
+            event.time = now;
+            event.frame = frame;
+            event.from = m_memorySize;
+            event.to = memory;
+            ++m_growthCount;
+        }
+        m_memorySize = memory;
+
+        const size_t used = heap_used();
+        const size_t top = heap_top();
+        m_peakUsed = used > m_peakUsed ? used : m_peakUsed;
+        m_peakTop = top > m_peakTop ? top : m_peakTop;
+    }
+
+    uint64_t growth_count() const { return m_growthCount; }
+    size_t memory_size() const { return m_memorySize ? m_memorySize : current_memory_size(); }
+
+    // Initial memory that would have held the session so far: the highest heap top seen, plus a quarter for headroom,
+    // in whole MiB (a multiple of the 64 KiB wasm page size).
+    size_t suggested_initial_memory() const
+    {
+        const size_t mib = 1024 * 1024;
+        const size_t wanted = m_peakTop + m_peakTop / 4;
+        return (wanted + mib - 1) / mib * mib;
+    }
+
+    void draw()
+    {
+#ifdef __EMSCRIPTEN__
+        const double mib = 1.0 / (1024.0 * 1024.0);
+        ImGui::Text("wasm memory %.1f MiB, initial %.1f MiB, grew %llu times", memory_size() * mib,
+                    configured_initial_memory() * mib, (unsigned long long)m_growthCount);
+        ImGui::Text("heap in use %.1f MiB (peak %.1f), top %.1f MiB (peak %.1f)", heap_used() * mib, m_peakUsed * mib,
+                    heap_top() * mib, m_peakTop * mib);
+        ImGui::Text("suggested JOYSTICK_INITIAL_MEMORY=%llu", (unsigned long long)suggested_initial_memory());
+        const uint64_t shown = m_growthCount < MaxGrowthEvents ? m_growthCount : static_cast<uint64_t>(MaxGrowthEvents);
+        for (uint64_t i = m_growthCount - shown; i < m_growthCount; ++i)
+        {
+            const GrowthEvent& event = m_growthEvents[i % MaxGrowthEvents];
+            ImGui::BulletText("[%.3f] frame %llu: %.1f -> %.1f MiB", event.time, (unsigned long long)event.frame,
+                              event.from * mib, event.to * mib);
+        }
+#else
+        ImGui::TextDisabled("No wasm memory in native builds");
+#endif
+
+        if (!allocation_counter::enabled())
+        {
+            ImGui::TextDisabled("Per-subsystem accounting is not compiled in");
+            return;
+        }
+        if (ImGui::BeginTable("memory_tags", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Subsystem");
+            ImGui::TableSetupColumn("Live KiB");
+            ImGui::TableSetupColumn("Peak KiB");
+            ImGui::TableHeadersRow();
+            for (int tag = 0; tag <= MemoryTag_Count; ++tag)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(tag < MemoryTag_Count ? memory_tag_name(tag) : "Total");
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", allocation_counter::live_bytes(tag) / 1024.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", allocation_counter::peak_bytes(tag) / 1024.0);
+            }
+            ImGui::EndTable();
+        }
+        if (ImGui::Button("Reset peaks"))
+        {
+            allocation_counter::reset_peaks();
+            m_peakUsed = heap_used();
+            m_peakTop = heap_top();
+        }
+    }
+
+    // What the build asked for, 0 when unknown.
+    static size_t configured_initial_memory()
+    {
+#ifdef JOYSTICK_INITIAL_MEMORY
+        return static_cast<size_t>(JOYSTICK_INITIAL_MEMORY);
+#else
+        return 0;
+#endif
+    }
+
+    static size_t current_memory_size()
+    {
+#ifdef __EMSCRIPTEN__
+        return emscripten_get_heap_size();
+#else
+        return 0;
+#endif
+    }
+
+    // Bytes malloc() has handed out and not got back.
+    static size_t heap_used()
+    {
+#ifdef __EMSCRIPTEN__
+        return static_cast<size_t>(mallinfo().uordblks);
+#else
+        const int64_t live = allocation_counter::live_bytes();
+        return live > 0 ? static_cast<size_t>(live) : 0;
+#endif
+    }
+
+    // End of the memory in use: static data, stack and everything below the heap's break. This, not heap_used(), is
+    // what has to fit into the wasm memory.
+    static size_t heap_top()
+    {
+#ifdef __EMSCRIPTEN__
+        return reinterpret_cast<size_t>(sbrk(0));
+#else
+        return heap_used();
+#endif
+    }
+
+private:
+    struct GrowthEvent
+    {
+        double time = 0;
+        uint64_t frame = 0;
+        size_t from = 0;
+        size_t to = 0;
+    };
+
+    size_t m_memorySize = 0;
+    size_t m_peakUsed = 0;
+    size_t m_peakTop = 0;
+    GrowthEvent m_growthEvents[MaxGrowthEvents];
+    uint64_t m_growthCount = 0;
+};
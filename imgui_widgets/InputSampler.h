@@ -0,0 +1,155 @@
+#pragma once
+
+#include "Clock.h"
+#include "JoystickSample.h"
+#include "SpscQueue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/html5.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+// Polls input at a fixed rate, independently of the render loop, and hands timestamped samples to the render side
+// through a wait-free SpscQueue. The render loop drains the queue once per frame, so every sample taken between two
+// frames reaches JoystickWidget instead of only the last one.
+//
+// Natively, polling runs on its own std::thread. In the browser the Gamepad API only exists on the main thread (it is
+// not exposed to workers), so the WASM build polls from a main-thread interval timer instead. Browsers clamp timers
+// to a few milliseconds and can only run them between frames, which still gives several samples per frame.
+class InputSampler
+{
+public:
+    enum { MaxSamplesPerPoll = 16 };
+
+    // Called at the sampling rate with the current time. Writes at most `max_samples` samples, returns how many.
+    typedef std::function<int(double timestamp, JoystickSample* samples, int max_samples)> PollFunction;
+
+    explicit InputSampler(size_t queue_capacity = 4096)
+        : m_queue(queue_capacity)
+    {
+    }
+
+    ~InputSampler()
+    {
+        stop();
+    }
+
+    InputSampler(const InputSampler&) = delete;
+    InputSampler& operator=(const InputSampler&) = delete;
+
+    void start(PollFunction poll, double rate_hz)
+    {
+        stop();
+        m_poll = std::move(poll);
+        m_rate = rate_hz > 1.0 ? rate_hz : 1.0;
+        m_running = true;
+#ifdef __EMSCRIPTEN__
+        m_interval = emscripten_set_interval(&InputSampler::interval_callback, 1000.0 / m_rate, this);
+#else
+        m_thread = std::thread(&InputSampler::run, this);
+#endif
+    }
+
+    void stop()
+    {
+        if (!m_running)
+            return;
+        m_running = false;
+#ifdef __EMSCRIPTEN__
+        emscripten_clear_interval(m_interval);
+#else
+        m_thread.join();
+#endif
+    }
+
+    bool is_running() const { return m_running; }
+    double rate() const { return m_rate; }
+
+    // Consumer side: passes every queued sample to `consume`, oldest first. Returns the number of samples drained.
+    template<typename Consumer>
+    int drain(Consumer&& consume)
+    {
+        JoystickSample sample;
+        int count = 0;
+        while (m_queue.try_pop(sample))
+        {
+            consume(sample);
+            ++count;
+        }
+        return count;
+    }
+
+    // Consumer side: pops at most `max_samples` queued samples, oldest first. Returns how many.
+    int pop(JoystickSample* samples, int max_samples)
+    {
+        int count = 0;
+        while (count < max_samples && m_queue.try_pop(samples[count]))
+            ++count;
+        return count;
+    }
+
+    uint64_t sampled() const { return m_sampled.load(std::memory_order_relaxed); }
+    // Samples lost because the render side didn't drain the queue in time.
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    void poll_once()
+    {
+        const int count = m_poll(now_seconds(), m_scratch, MaxSamplesPerPoll);
+        for (int i = 0; i < count; ++i)
+        {
+            if (m_queue.try_push(m_scratch[i]))
+                m_sampled.fetch_add(1, std::memory_order_relaxed);
+            else
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+#ifdef __EMSCRIPTEN__
+    static void interval_callback(void* user_data)
+    {
+        static_cast<InputSampler*>(user_data)->poll_once();
+    }
+#else
+    void run()
+    {
+        using namespace std::chrono;
+        const steady_clock::duration period = duration_cast<steady_clock::duration>(duration<double>(1.0 / m_rate));
+
+        steady_clock::time_point next = steady_clock::now();
+        while (m_running.load(std::memory_order_relaxed))
+        {
+            poll_once();
+
+            // Keep a steady cadence, but don't try to catch up with a burst after a stall.
+            next += period;
+            const steady_clock::time_point now = steady_clock::now();
+            if (next < now - period)
+                next = now;
+            std::this_thread::sleep_until(next);
+        }
+    }
+#endif
+
+private:
+    SpscQueue<JoystickSample> m_queue;
+    PollFunction m_poll;
+    double m_rate = 1000.0;
+    std::atomic<bool> m_running{false};
+    JoystickSample m_scratch[MaxSamplesPerPoll];
+
+    std::atomic<uint64_t> m_sampled{0};
+    std::atomic<uint64_t> m_dropped{0};
+
+#ifdef __EMSCRIPTEN__
+    long m_interval = 0;
+#else
+    std::thread m_thread;
+#endif
+};
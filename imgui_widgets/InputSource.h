@@ -0,0 +1,40 @@
+#pragma once
+
+#include "JoystickSample.h"
+
+// Receives hotplug notifications from an InputSource. Joystick ids are slots in [0, DeviceRegistry::MaxDevices).
+class InputListener
+{
+public:
+    virtual void device_connected(int joystick_id, const char* name) = 0;
+    virtual void device_disconnected(int joystick_id) = 0;
+
+protected:
+    ~InputListener() {}
+};
+
+// Where joystick samples come from. Implementations differ in how they get them (GlfwInputSource polls at a fixed
+// rate, SdlInputSource turns SDL joystick events into samples) but all of them hand out timestamped JoystickSamples
+// through poll(), which the app feeds to JoystickWidget::update() regardless of the source.
+class InputSource
+{
+public:
+    virtual ~InputSource() {}
+
+    virtual const char* name() const = 0;
+
+    // Starts delivering samples. Devices that are already present are reported to `listener` as connected, either
+    // right away or on the next poll.
+    virtual void start(InputListener* listener) = 0;
+    virtual void stop() = 0;
+
+    // Writes at most `max_samples` samples taken since the previous call, oldest first. Returns how many were written,
+    // 0 once there are none left. Called from the main loop.
+    virtual int poll(JoystickSample* samples, int max_samples) = 0;
+
+    // Samples lost because the main loop didn't poll them in time.
+    virtual uint64_t dropped() const = 0;
+
+    // One or two lines of ImGui text describing the source and its counters.
+    virtual void draw_status() const = 0;
+};
@@ -0,0 +1,356 @@
+#pragma once
+
+// Everything the GLFW and SDL apps have in common: one JoystickWidget per device slot, the device and event logs,
+// session recording and replay, frame timing and render throttling. The platform specific parts (window, GL context,
+// event loop and where samples come from) stay in main_glfw.cpp / main_sdl.cpp, which feed the app through an
+// InputSource.
+
+#include "imgui.h"
+#include "implot.h"
+#include "AllocationCounter.h"
+#include "AxisFilters.h"
+#include "Clock.h"
+#include "DeviceRegistry.h"
+#include "FrameProfiler.h"
+#include "GlPaintTexture.h"
+#include "HeapMonitor.h"
+#include "InputSource.h"
+#include "JoystickEventLog.h"
+#include "JoystickWidget.h"
+#include "RenderThrottle.h"
+#include "SessionRecording.h"
+#include "SimpleLogger.h"
+#include "StartupProbe.h"
+
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+class JoystickApp : public InputListener
+{
+public:
+    // Recordings are capped so they fit into the fixed wasm memory (JOYSTICK_INITIAL_MEMORY), see HeapMonitor.
+    enum { MaxSamplesPerPoll = 64, MaxRecordingBytes = 8 * 1024 * 1024 };
+
+    explicit JoystickApp(InputSource& input)
+        : m_input(input), m_realtimeReplay(m_sessionReplay)
+    {
+        m_sessionRecorder.set_max_bytes(MaxRecordingBytes);
+    }
+
+    void start()
+    {
+        m_input.start(this);
+    }
+
+    FrameProfiler& profiler() { return m_frameProfiler; }
+    RenderThrottle& throttle() { return m_renderThrottle; }
+    StartupProbe& startup() { return m_startup; }
+    FrameAllocations& allocations() { return m_frameAllocations; }
+
+    void device_connected(int joystick_id, const char* name) override
+    {
+        if (!m_devices.connect(joystick_id))
+            return;
+
+        m_deviceLog.AddLog("[%.3f] connected %d: %s\n", now_seconds(), joystick_id, name);
+        m_deviceNames[joystick_id] = name;
+        if (!m_replaying)
+            joystick_widget(joystick_id).set_device(joystick_id, name);
+        m_axisFilters.reset(joystick_id);
+        m_renderThrottle.notify_activity();
+        m_frameAllocations.rearm();
+    }
+
+    void device_disconnected(int joystick_id) override
+    {
+        if (!m_devices.disconnect(joystick_id))
+            return;
+
+        m_deviceLog.AddLog("[%.3f] disconnected %d\n", now_seconds(), joystick_id);
+        m_renderThrottle.notify_activity();
+        m_frameAllocations.rearm();
+    }
+
+    // Feeds input into the widgets, runs on every main loop iteration, rendered or not. Returns whether any widget saw
+    // a change.
+    bool update()
+    {
+        ScopedFrameTimer timer(m_frameProfiler, FrameMetric_Update);
+        m_heapMonitor.update(now_seconds(), static_cast<uint64_t>(ImGui::GetFrameCount()));
+        JoystickSample samples[MaxSamplesPerPoll];
+        bool changed = false;
+        m_frameSampleCount = 0;
+
+        if (m_replaying)
+        {
+            // Live input is discarded while a recording plays back.
+            while (m_input.poll(samples, MaxSamplesPerPoll) > 0)
+            {
+            }
+            return replay_joysticks();
+        }
+
+        int count = 0;
+        while ((count = m_input.poll(samples, MaxSamplesPerPoll)) > 0)
+        {
+            // Recorded unfiltered, a replay goes through the filters again, with the settings of then.
+            for (int i = 0; i < count; ++i)
+            {
+                if (m_devices.is_connected(samples[i].joystick_id))
+                    m_sessionRecorder.record(samples[i]);
+            }
+            m_axisFilters.process(samples, count);
+
+            for (int i = 0; i < count; ++i)
+            {
+                const JoystickSample& sample = samples[i];
+                // Samples of a device unplugged since they were taken are dropped.
+                if (!m_devices.is_connected(sample.joystick_id))
+                    continue;
+                changed |= m_joystickWidgets[sample.joystick_id]->update(sample);
+                m_frameProfiler.add_input(sample.timestamp);
+            }
+            m_frameSampleCount += count;
+        }
+        return changed;
+    }
+
+    // Builds all windows, between ImGui::NewFrame() and ImGui::Render(). Part of FrameMetric_Build, which the main loop
+    // times.
+    void draw()
+    {
+        draw_demo_windows();
+        draw_input_window();
+        draw_recording_window();
+        draw_rendering_window();
+
+        for (int joystick_id : m_replaying ? m_replayDevices : m_devices)
+            m_joystickWidgets[joystick_id]->draw();
+
+        m_joystickEvents.draw("Joystick events");
+        m_deviceLog.Draw("Devices");
+        m_frameProfiler.draw("Frame timing");
+    }
+
+private:
+    // One widget per slot, created on first connection and kept around (with its history) if the device is plugged in
+    // again.
+    JoystickWidget& joystick_widget(int joystick_id)
+    {
+        std::unique_ptr<JoystickWidget>& widget = m_joystickWidgets[joystick_id];
+        if (!widget)
+        {
+            widget.reset(new JoystickWidget("Joystick " + std::to_string(joystick_id)));
+            widget->set_initial_position(ImVec2(300.f + 30.f * joystick_id, 20.f + 30.f * joystick_id));
+            widget->set_event_log(&m_joystickEvents);
+            widget->set_upstream_deadzone(m_axisFilters.enabled());
+            widget->paint_canvas().set_texture(std::unique_ptr<PaintTexture>(new GlPaintTexture()));
+        }
+        return *widget;
+    }
+
+    void stop_replay()
+    {
+        m_replaying = false;
+        m_axisFilters.reset();
+        m_renderThrottle.notify_activity();
+        m_frameAllocations.rearm();
+        // Replayed samples went to the same widgets, give the live devices their names back.
+        for (int joystick_id : m_devices)
+            joystick_widget(joystick_id).set_device(joystick_id, m_deviceNames[joystick_id].c_str());
+    }
+
+    bool replay_joysticks()
+    {
+        JoystickSample samples[MaxSamplesPerPoll];
+        bool changed = false;
+        int count = 0;
+        while ((count = m_realtimeReplay.poll(now_seconds(), samples, MaxSamplesPerPoll)) > 0)
+        {
+            m_axisFilters.process(samples, count);
+            for (int i = 0; i < count; ++i)
+            {
+                const JoystickSample& sample = samples[i];
+                JoystickWidget& widget = joystick_widget(sample.joystick_id);
+                if (m_replayDevices.connect(sample.joystick_id))
+                {
+                    char name[32];
+                    snprintf(name, sizeof(name), "Replay %d", sample.joystick_id);
+                    widget.set_device(sample.joystick_id, name);
+                    m_frameAllocations.rearm();
+                }
+                changed |= widget.update(sample);
+                m_frameProfiler.add_input(sample.timestamp);
+            }
+            m_frameSampleCount += count;
+        }
+
+        if (m_realtimeReplay.finished())
+            stop_replay();
+        return changed;
+    }
+
+    void draw_input_window()
+    {
+        ImGui::Begin("Input");
+        m_input.draw_status();
+        ImGui::Text("%d samples this frame", m_frameSampleCount);
+
+        bool filters_enabled = m_axisFilters.enabled();
+        if (ImGui::Checkbox("Axis filters", &filters_enabled))
+        {
+            m_axisFilters.set_enabled(filters_enabled);
+            m_axisFilters.reset();
+            // The widgets deadzone the samples themselves while the pipeline is off.
+            for (std::unique_ptr<JoystickWidget>& widget : m_joystickWidgets)
+                if (widget)
+                    widget->set_upstream_deadzone(filters_enabled);
+        }
+        for (int joystick_id : m_replaying ? m_replayDevices : m_devices)
+        {
+            if (ImGui::TreeNode(m_joystickWidgets[joystick_id].get(), "Filters, joystick %d", joystick_id))
+            {
+                m_axisFilters.draw(joystick_id, m_joystickWidgets[joystick_id]->state().axes_count);
+                ImGui::TreePop();
+            }
+        }
+        ImGui::End();
+    }
+
+    void draw_recording_window()
+    {
+        ImGui::Begin("Recording");
+        if (m_sessionRecorder.is_recording())
+        {
+            if (ImGui::Button("Stop recording"))
+            {
+                m_sessionRecorder.end();
+                m_frameAllocations.rearm();
+            }
+        }
+        else if (m_replaying)
+        {
+            if (ImGui::Button("Stop replay"))
+                stop_replay();
+        }
+        else
+        {
+            if (ImGui::Button("Record"))
+            {
+                m_sessionRecorder.begin();
+                m_frameAllocations.rearm();
+            }
+
+            // The replay reads the recorder's buffer directly, which is why it can't be recorded into meanwhile.
+            const std::vector<uint8_t>& data = m_sessionRecorder.data();
+            if (m_sessionRecorder.sample_count() > 0)
+            {
+                ImGui::SameLine();
+                if (ImGui::Button("Replay") && m_sessionReplay.open(data.data(), data.size()))
+                {
+                    m_replayDevices = DeviceRegistry();
+                    m_axisFilters.reset();
+                    m_realtimeReplay.start(now_seconds());
+                    m_replaying = true;
+                }
+            }
+        }
+
+        const uint64_t samples = m_sessionRecorder.sample_count();
+        ImGui::Text("%llu samples, %zu bytes (%.1f bytes/sample)", (unsigned long long)samples,
+                    m_sessionRecorder.data().size(), samples ? (double)m_sessionRecorder.data().size() / samples : 0.0);
+        if (m_sessionRecorder.full())
+            ImGui::TextDisabled("Stopped at the %zu MiB limit", m_sessionRecorder.max_bytes() / (1024 * 1024));
+        ImGui::End();
+    }
+
+    void draw_rendering_window()
+    {
+        ImGui::Begin("Rendering");
+        bool enabled = m_renderThrottle.enabled();
+        if (ImGui::Checkbox("Render only on change", &enabled))
+            m_renderThrottle.set_enabled(enabled);
+        float refresh_interval = static_cast<float>(m_renderThrottle.refresh_interval());
+        if (ImGui::SliderFloat("Refresh interval (s)", &refresh_interval, 0.05f, 5.f, "%.2f"))
+            m_renderThrottle.set_refresh_interval(refresh_interval);
+
+        const uint64_t rendered = m_renderThrottle.rendered();
+        const uint64_t skipped = m_renderThrottle.skipped();
+        ImGui::Text("%llu frames rendered, %llu skipped (%.1f%%)", (unsigned long long)rendered,
+                    (unsigned long long)skipped, rendered + skipped ? 100.0 * skipped / (rendered + skipped) : 0.0);
+
+        if (ImGui::TreeNode("Startup"))
+        {
+            m_startup.draw();
+            ImGui::TreePop();
+        }
+
+        if (ImGui::TreeNode("Allocations"))
+        {
+            m_frameAllocations.draw();
+            ImGui::TreePop();
+        }
+
+        if (ImGui::TreeNode("Memory"))
+        {
+            m_heapMonitor.draw();
+            ImGui::TreePop();
+        }
+        ImGui::End();
+    }
+
+    // Production builds (JOYSTICK_PRODUCTION) don't link the demo windows.
+    void draw_demo_windows()
+    {
+#ifndef IMGUI_DISABLE_DEMO_WINDOWS
+        ImGui::Begin("Demo windows");
+        ImGui::Checkbox("Show ImGui demo window", &m_showDemoWindow);
+        ImGui::Checkbox("Show ImPlot demo window", &m_showPlotDemoWindow);
+        ImGui::End();
+
+        if (m_showDemoWindow)
+            ImGui::ShowDemoWindow(&m_showDemoWindow);
+
+        if (m_showPlotDemoWindow)
+            ImPlot::ShowDemoWindow(&m_showPlotDemoWindow);
+#endif
+    }
+
+private:
+    InputSource& m_input;
+
+    // Connected devices, maintained from the InputSource's hotplug notifications.
+    DeviceRegistry m_devices;
+    std::array<std::unique_ptr<JoystickWidget>, DeviceRegistry::MaxDevices> m_joystickWidgets;
+    std::string m_deviceNames[DeviceRegistry::MaxDevices];
+    int m_frameSampleCount = 0;
+
+    ExampleAppLog m_deviceLog;
+    JoystickEventLog m_joystickEvents;
+
+    // Session recording and replay, see SessionRecording.h. There is no filesystem in the browser, so the recording
+    // is kept in memory. While a recording plays back, the replayed devices are shown instead of the live ones.
+    SessionRecorder m_sessionRecorder;
+    SessionReplay m_sessionReplay;
+    RealtimeReplay m_realtimeReplay;
+    DeviceRegistry m_replayDevices;
+    bool m_replaying = false;
+
+    // Calibration, deadzones, response curves and smoothing of the axes, between the input and the widgets.
+    AxisFilterPipeline m_axisFilters;
+
+    // Per-stage timing of the main loop and the age of the inputs presented by each frame.
+    FrameProfiler m_frameProfiler;
+    // Skips building and presenting frames while nothing changes, see RenderThrottle.
+    RenderThrottle m_renderThrottle;
+    StartupProbe m_startup;
+    // Heap allocations per presented frame, none once warmed up.
+    FrameAllocations m_frameAllocations;
+    // Wasm memory size and growth, live heap per subsystem.
+    HeapMonitor m_heapMonitor;
+
+    bool m_showDemoWindow = false;
+    bool m_showPlotDemoWindow = false;
+};
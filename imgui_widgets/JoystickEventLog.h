@@ -0,0 +1,248 @@
+#pragma once
+
+#include "imgui.h"
+#include "AllocationCounter.h"
+#include "FilteredIndex.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+enum JoystickEventKind : uint8_t
+{
+    JoystickEventKind_Axis,
+    JoystickEventKind_Button,
+};
+
+// One axis or button change. Kept as is in the log, text is only produced for the rows on screen.
+struct JoystickEvent
+{
+    double timestamp;
+    float value;
+    uint16_t index;
+    uint8_t device;
+    uint8_t kind;
+};
+
+static_assert(sizeof(JoystickEvent) == 16, "JoystickEvent is expected to stay compact");
+
+// Filter on the structured fields of JoystickEvent.
+struct JoystickEventFilter
+{
+    bool axes = true;
+    bool buttons = true;
+    int device = -1; // -1 for any device.
+    int index = -1;  // -1 for any axis/button.
+    float value_min = -1.f;
+    float value_max = 1.f;
+
+    bool is_active() const
+    {
+        return !axes || !buttons || device >= 0 || index >= 0 || value_min > -1.f || value_max < 1.f;
+    }
+
+    bool pass(const JoystickEvent& event) const
+    {
+        if (event.kind == JoystickEventKind_Axis ? !axes : !buttons)
+            return false;
+        if (device >= 0 && event.device != device)
+            return false;
+        if (index >= 0 && event.index != index)
+            return false;
+        return event.value >= value_min && event.value <= value_max;
+    }
+};
+
+// Fixed-capacity ring of JoystickEvent records shared by all devices. Adding an event is a 16 byte store, no
+// formatting and no string copies: device names are kept once per device.
+class JoystickEventLog
+{
+public:
+    enum { MaxDevices = 16, MaxNameLength = 64 };
+
+    explicit JoystickEventLog(int capacity = 64 * 1024)
+        : m_filtered(capacity > 1 ? capacity : 1)
+    {
+        ScopedMemoryTag tag(MemoryTag_Logger);
+        m_events.resize(capacity > 1 ? capacity : 1);
+        std::memset(m_deviceNames, 0, sizeof(m_deviceNames));
+    }
+
+    void set_device_name(int device, const char* name)
+    {
+        if (device < 0 || device >= MaxDevices)
+            return;
+        std::strncpy(m_deviceNames[device], name ? name : "", MaxNameLength - 1);
+        m_deviceNames[device][MaxNameLength - 1] = '\0';
+    }
+
+    const char* device_name(int device) const
+    {
+        return device >= 0 && device < MaxDevices ? m_deviceNames[device] : "";
+    }
+
+    void add(double timestamp, int device, JoystickEventKind kind, int index, float value)
+    {
+        if (m_size == static_cast<int>(m_events.size()))
+        {
+            m_first = (m_first + 1) % static_cast<int>(m_events.size());
+            --m_size;
+            ++m_firstRecord;
+            ++m_dropped;
+        }
+
+        JoystickEvent& event = m_events[(m_first + m_size) % m_events.size()];
+        event.timestamp = timestamp;
+        event.value = value;
+        event.index = static_cast<uint16_t>(index);
+        event.device = static_cast<uint8_t>(device);
+        event.kind = kind;
+        ++m_size;
+
+        if (m_filter.is_active())
+        {
+            m_filtered.drop_before(m_firstRecord);
+            m_filtered.append(m_firstRecord + m_size - 1, RecordFilter{ this });
+        }
+    }
+
+    void clear()
+    {
+        m_firstRecord += m_size;
+        m_first = 0;
+        m_size = 0;
+        m_filtered.reset(m_firstRecord);
+    }
+
+    int size() const { return m_size; }
+    uint64_t dropped() const { return m_dropped; }
+
+    // Event `i` counted from the oldest one.
+    const JoystickEvent& operator[](int i) const
+    {
+        return m_events[(m_first + i) % m_events.size()];
+    }
+
+    void draw(const char* title, bool* p_open = NULL)
+    {
+        if (!ImGui::Begin(title, p_open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        if (ImGui::BeginPopup("Options"))
+        {
+            ImGui::Checkbox("Auto-scroll", &m_autoScroll);
+            ImGui::EndPopup();
+        }
+
+        if (ImGui::Button("Options"))
+            ImGui::OpenPopup("Options");
+        ImGui::SameLine();
+        const bool clear_log = ImGui::Button("Clear");
+        ImGui::SameLine();
+        const bool copy = ImGui::Button("Copy");
+
+        if (draw_filter())
+            m_filtered.reset(m_firstRecord);
+
+        const bool filtered = m_filter.is_active();
+        if (filtered)
+        {
+            m_filtered.drop_before(m_firstRecord);
+            if (!m_filtered.scan(end_record(), RecordFilter{ this }))
+                ImGui::ProgressBar(m_filtered.progress(end_record()), ImVec2(-1.0f, 0.0f), "Filtering...");
+        }
+
+        ImGui::TextDisabled("%d events, %llu dropped", m_size, (unsigned long long)m_dropped);
+
+        ImGui::Separator();
+        ImGui::BeginChild("scrolling", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+
+        if (clear_log)
+            clear();
+        if (copy)
+            ImGui::LogToClipboard();
+
+        ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, 0));
+        ImGuiListClipper clipper;
+        clipper.Begin(filtered ? m_filtered.size() : m_size);
+        while (clipper.Step())
+        {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+            {
+                const int i = filtered ? static_cast<int>(m_filtered[row] - m_firstRecord) : row;
+                draw_event((*this)[i]);
+            }
+        }
+        clipper.End();
+        ImGui::PopStyleVar();
+
+        if (m_autoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+            ImGui::SetScrollHereY(1.0f);
+
+        ImGui::EndChild();
+        ImGui::End();
+    }
+
+private:
+    struct RecordFilter
+    {
+        const JoystickEventLog* log;
+
+        bool operator()(uint64_t record) const
+        {
+            return log->m_filter.pass((*log)[static_cast<int>(record - log->m_firstRecord)]);
+        }
+    };
+
+    uint64_t end_record() const
+    {
+        return m_firstRecord + m_size;
+    }
+
+    bool draw_filter()
+    {
+        bool changed = false;
+        changed |= ImGui::Checkbox("Axes", &m_filter.axes);
+        ImGui::SameLine();
+        changed |= ImGui::Checkbox("Buttons", &m_filter.buttons);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(90.0f);
+        changed |= ImGui::InputInt("Device", &m_filter.device);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(90.0f);
+        changed |= ImGui::InputInt("Index", &m_filter.index);
+        changed |= ImGui::DragFloatRange2("Value", &m_filter.value_min, &m_filter.value_max, 0.01f, -1.0f, 1.0f);
+
+        if (m_filter.device < -1)
+            m_filter.device = -1;
+        if (m_filter.index < -1)
+            m_filter.index = -1;
+        return changed;
+    }
+
+    void draw_event(const JoystickEvent& event) const
+    {
+        if (event.kind == JoystickEventKind_Axis)
+            ImGui::Text("[%10.3f] (%d %s) axis %d = %f", event.timestamp, event.device, device_name(event.device),
+                        event.index, event.value);
+        else
+            ImGui::Text("[%10.3f] (%d %s) button %d = %d", event.timestamp, event.device, device_name(event.device),
+                        event.index, static_cast<int>(event.value));
+    }
+
+private:
+    std::vector<JoystickEvent> m_events;
+    int m_first = 0;
+    int m_size = 0;
+    uint64_t m_firstRecord = 0; // Monotonic number of the oldest event, see FilteredIndex.
+    uint64_t m_dropped = 0;
+
+    char m_deviceNames[MaxDevices][MaxNameLength];
+
+    JoystickEventFilter m_filter;
+    FilteredIndex m_filtered;
+    bool m_autoScroll = true;
+};
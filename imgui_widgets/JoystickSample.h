@@ -0,0 +1,39 @@
+#pragma once
+
+#include "StateDiff.h"
+
+#include <cstdint>
+#include <cstring>
+
+// Snapshot of one device at one point in time, as passed from input sampling to JoystickWidget. Fixed size and
+// trivially copyable so it can travel through SpscQueue. Buttons are packed one bit per button.
+struct JoystickSample
+{
+    enum { MaxAxes = 16, MaxButtons = 128, ButtonWords = MaxButtons / 32 };
+
+    double timestamp = 0;
+    int joystick_id = -1;
+    int axes_count = 0;
+    int button_count = 0;
+    alignas(16) float axes[MaxAxes] = {};
+    alignas(16) uint32_t buttons[ButtonWords] = {};
+
+    void set(int id, double time, int in_axes_count, const float* in_axes,
+             int in_button_count, const uint8_t* in_buttons)
+    {
+        joystick_id = id;
+        timestamp = time;
+        axes_count = in_axes_count < MaxAxes ? in_axes_count : MaxAxes;
+        button_count = in_button_count < MaxButtons ? in_button_count : MaxButtons;
+
+        std::memcpy(axes, in_axes, axes_count * sizeof(float));
+        std::memset(axes + axes_count, 0, (MaxAxes - axes_count) * sizeof(float));
+        std::memset(buttons, 0, sizeof(buttons));
+        state_diff::pack_buttons(in_buttons, button_count, buttons);
+    }
+
+    bool button(int i) const
+    {
+        return i < button_count && (buttons[i / 32] >> (i % 32)) & 1u;
+    }
+};
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "JoystickSample.h"
+
+#include "imgui.h"
+#include "implot.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Running mean and variance (Welford), plus the least-squares slope of the values over time computed from running
+// co-moments, so the trend of a long stream is available without keeping the stream.
+struct RunningStatistics
+{
+    uint64_t count = 0;
+    double mean = 0;
+    double m2 = 0;
+    double mean_time = 0;
+    double m2_time = 0;
+    double co_moment = 0;
+
+    void add(double time, double value)
+    {
+        ++count;
+        const double delta = value - mean;
+        const double delta_time = time - mean_time;
+        mean += delta / count;
+        mean_time += delta_time / count;
+        m2 += delta * (value - mean);
+        m2_time += delta_time * (time - mean_time);
+        co_moment += delta_time * (value - mean);
+    }
+
+    double variance() const { return count > 1 ? m2 / (count - 1) : 0.0; }
+    double stddev() const { return std::sqrt(variance()); }
+    // Change of the value per second, 0 until there are samples at two different times.
+    double slope() const { return m2_time > 0 ? co_moment / m2_time : 0.0; }
+};
+
+struct AxisStatistics
+{
+    RunningStatistics all;
+    float min = 0;
+    float max = 0;
+
+    // Samples within the rest radius of the axis' resting value. The spread of these is the jitter at rest, their
+    // slope over time the drift.
+    float rest_value = 0;
+    RunningStatistics rest;
+};
+
+// Incremental per-device statistics for qualifying controllers: per axis mean, standard deviation, min/max, jitter
+// and drift at rest; per device the sample rate, the rate at which the axes actually change, and a fixed-resolution
+// occupancy histogram of axes 0/1. add() is O(axes) with constant memory, it never looks at past samples.
+//
+// The resting value of every axis is taken from the first sample after a reset (GLFW reports released triggers as -1,
+// sticks as ~0), so reset with the controller untouched.
+class JoystickStatistics
+{
+public:
+    enum { MaxAxes = JoystickSample::MaxAxes, HeatmapSize = 64 };
+
+    JoystickStatistics()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        for (AxisStatistics& axis : m_axes)
+            axis = AxisStatistics();
+        std::memset(m_heatmap, 0, sizeof(m_heatmap));
+        std::memset(m_previousAxes, 0, sizeof(m_previousAxes));
+        m_heatmapMax = 0;
+        m_visitedCells = 0;
+        m_samples = 0;
+        m_axesCount = 0;
+        m_origin = 0;
+        m_lastSample = 0;
+        m_lastChange = 0;
+        m_sampleInterval = 0;
+        m_changeInterval = 0;
+        m_maxInterval = 0;
+    }
+
+    void set_rest_radius(float radius) { m_restRadius = radius; }
+    float rest_radius() const { return m_restRadius; }
+
+    void add(const JoystickSample& sample)
+    {
+        const int axes_count = sample.axes_count < MaxAxes ? sample.axes_count : static_cast<int>(MaxAxes);
+        const bool first = m_samples == 0;
+        if (first)
+        {
+            m_origin = sample.timestamp;
+            m_lastSample = m_lastChange = sample.timestamp;
+            for (int i = 0; i < axes_count; ++i)
+            {
+                m_axes[i].min = m_axes[i].max = sample.axes[i];
+                m_axes[i].rest_value = sample.axes[i];
+            }
+        }
+        m_axesCount = axes_count;
+        ++m_samples;
+
+        const double time = sample.timestamp - m_origin;
+        for (int i = 0; i < axes_count; ++i)
+        {
+            AxisStatistics& axis = m_axes[i];
+            const float value = sample.axes[i];
+            axis.all.add(time, value);
+            if (value < axis.min)
+                axis.min = value;
+            if (value > axis.max)
+                axis.max = value;
+            if (std::fabs(value - axis.rest_value) < m_restRadius)
+                axis.rest.add(time, value);
+        }
+
+        if (!first)
+        {
+            // Exponential moving averages of the intervals, over roughly the last 100 samples.
+            const double interval = sample.timestamp - m_lastSample;
+            m_sampleInterval = m_sampleInterval > 0 ? m_sampleInterval + (interval - m_sampleInterval) * 0.01 : interval;
+            if (interval > m_maxInterval)
+                m_maxInterval = interval;
+            m_lastSample = sample.timestamp;
+
+            if (std::memcmp(m_previousAxes, sample.axes, axes_count * sizeof(float)) != 0)
+            {
+                const double change_interval = sample.timestamp - m_lastChange;
+                m_changeInterval = m_changeInterval > 0 ? m_changeInterval + (change_interval - m_changeInterval) * 0.01
+                                                        : change_interval;
+                m_lastChange = sample.timestamp;
+            }
+        }
+        std::memcpy(m_previousAxes, sample.axes, axes_count * sizeof(float));
+
+        if (axes_count >= 2)
+            add_to_heatmap(sample.axes[0], sample.axes[1]);
+    }
+
+    uint64_t samples() const { return m_samples; }
+    int axes_count() const { return m_axesCount; }
+    const AxisStatistics& axis(int i) const { return m_axes[i]; }
+
+    // Samples per second, and how often the axis values actually change: polled devices are sampled faster than they
+    // report.
+    double sample_rate() const { return m_sampleInterval > 0 ? 1.0 / m_sampleInterval : 0.0; }
+    double change_rate() const { return m_changeInterval > 0 ? 1.0 / m_changeInterval : 0.0; }
+    double max_interval() const { return m_maxInterval; }
+
+    // HeatmapSize x HeatmapSize sample counts, row-major, top row first (ImPlot's heatmap layout), covering [-1, 1].
+    const uint32_t* heatmap() const { return m_heatmap; }
+    uint32_t heatmap_max() const { return m_heatmapMax; }
+    // Visited cells relative to the number of cells within the unit circle. Square gates can go slightly above 1.
+    double coverage() const { return m_visitedCells / circle_cells(); }
+
+    void draw()
+    {
+        if (ImGui::Button("Reset statistics"))
+            reset();
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100);
+        ImGui::SliderFloat("Rest radius", &m_restRadius, 0.01f, 0.5f, "%.2f");
+
+        ImGui::Text("%llu samples, %.0f samples/s, axes change %.0f times/s, longest gap %.1f ms",
+                    (unsigned long long)m_samples, sample_rate(), change_rate(), m_maxInterval * 1e3);
+
+        if (ImGui::BeginTable("axis_statistics", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Axis");
+            ImGui::TableSetupColumn("Mean");
+            ImGui::TableSetupColumn("Std dev");
+            ImGui::TableSetupColumn("Min");
+            ImGui::TableSetupColumn("Max");
+            ImGui::TableSetupColumn("Rest jitter");
+            ImGui::TableSetupColumn("Drift /min");
+            ImGui::TableHeadersRow();
+
+            for (int i = 0; i < m_axesCount; ++i)
+            {
+                const AxisStatistics& axis = m_axes[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", i);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4f", axis.all.mean);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4f", axis.all.stddev());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4f", axis.min);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4f", axis.max);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.5f", axis.rest.stddev());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.5f", axis.rest.slope() * 60.0);
+            }
+            ImGui::EndTable();
+        }
+
+        if (m_axesCount < 2)
+            return;
+
+        ImGui::Text("Coverage of axes 0/1: %.1f%%", coverage() * 100.0);
+
+        // Log scale, otherwise the resting position outweighs everything else.
+        for (int i = 0; i < HeatmapSize * HeatmapSize; ++i)
+            m_heatmapDisplay[i] = std::log1p(static_cast<float>(m_heatmap[i]));
+
+        ImPlot::PushColormap(ImPlotColormap_Viridis);
+        ImPlot::SetNextPlotLimits(-1, 1, -1, 1, ImGuiCond_Always);
+        if (ImPlot::BeginPlot("Coverage", NULL, NULL, ImVec2(-1, 300), ImPlotFlags_Equal | ImPlotFlags_NoLegend))
+        {
+            ImPlot::PlotHeatmap("##coverage", m_heatmapDisplay, HeatmapSize, HeatmapSize, 0.0,
+                                std::log1p(static_cast<double>(m_heatmapMax)), NULL, ImPlotPoint(-1, -1),
+                                ImPlotPoint(1, 1));
+            ImPlot::EndPlot();
+        }
+        ImPlot::PopColormap();
+    }
+
+private:
+    static int heatmap_index(float value)
+    {
+        const int index = static_cast<int>((value + 1.f) * 0.5f * HeatmapSize);
+        return index < 0 ? 0 : (index >= HeatmapSize ? HeatmapSize - 1 : index);
+    }
+
+    static double circle_cells()
+    {
+        return 3.14159265358979 * 0.25 * HeatmapSize * HeatmapSize;
+    }
+
+    void add_to_heatmap(float x, float y)
+    {
+        // Row 0 is the top of the plot, y = 1.
+        const int row = HeatmapSize - 1 - heatmap_index(y);
+        const int column = heatmap_index(x);
+        uint32_t& cell = m_heatmap[row * HeatmapSize + column];
+        if (cell == 0)
+            ++m_visitedCells;
+        ++cell;
+        if (cell > m_heatmapMax)
+            m_heatmapMax = cell;
+    }
+
+private:
+    AxisStatistics m_axes[MaxAxes];
+    float m_previousAxes[MaxAxes];
+    int m_axesCount = 0;
+    float m_restRadius = 0.1f;
+
+    uint64_t m_samples = 0;
+    double m_origin = 0;
+    double m_lastSample = 0;
+    double m_lastChange = 0;
+    double m_sampleInterval = 0;
+    double m_changeInterval = 0;
+    double m_maxInterval = 0;
+
+    uint32_t m_heatmap[HeatmapSize * HeatmapSize];
+    float m_heatmapDisplay[HeatmapSize * HeatmapSize];
+    uint32_t m_heatmapMax = 0;
+    int m_visitedCells = 0;
+};
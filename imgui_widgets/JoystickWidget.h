@@ -5,87 +5,203 @@
 #include "imgui.h"
 #include "imgui_internal.h"
 #include "implot.h"
-#include "SimpleLogger.h"
+#include "AllocationCounter.h"
+#include "JoystickEventLog.h"
+#include "JoystickSample.h"
+#include "JoystickStatistics.h"
+#include "PaintCanvas.h"
+#include "SampleHistory.h"
+#include "StateDiff.h"
 
+#include <cstdio>
+#include <cstring>
 #include <string>
+#include <utility>
 #include <vector>
 
 
 struct JoystickState
 {
-    std::vector<float> axes;
-    std::vector<uint8_t> buttons;
+    enum
+    {
+        MaxAxes = JoystickSample::MaxAxes,
+        MaxButtons = JoystickSample::MaxButtons,
+        ButtonWords = JoystickSample::ButtonWords,
+    };
+
+    alignas(16) float axes[MaxAxes] = {};
+    alignas(16) uint32_t buttons[ButtonWords] = {}; // One bit per button.
+    int axes_count = 0;
+    int button_count = 0;
     std::string name;
-    int joystick_id;
+    int joystick_id = -1;
+
+    bool button(int i) const
+    {
+        return i < button_count && (buttons[i / 32] >> (i % 32)) & 1u;
+    }
+};
+
+// Decides which differences between two polls count as changes.
+struct ChangeDetectionConfig
+{
+    // Axis values closer to 0 than this are treated as 0. Skipped when the samples come through a filter pipeline that
+    // applies its own deadzones, see JoystickWidget::set_upstream_deadzone().
+    alignas(16) float deadzone[JoystickState::MaxAxes];
+    // An axis is reported as changed once it moves further than this from the last value reported for it.
+    alignas(16) float hysteresis[JoystickState::MaxAxes];
+    // Axes never reported as changed.
+    uint32_t ignored_axes = 1u << 8;
+    // Axes reported as changed but not recorded in the event log (the main stick is plotted instead).
+    uint32_t unlogged_axes = (1u << 0) | (1u << 1);
+
+    ChangeDetectionConfig()
+    {
+        for (int i = 0; i < JoystickState::MaxAxes; ++i)
+        {
+            deadzone[i] = 0.f;
+            hysteresis[i] = 0.01f;
+        }
+    }
 };
 
 class JoystickWidget
 {
 public:
+    // The title is used as the ImGui window name, so every widget drawn in the same frame needs its own.
+    // The history keeps MaxHistorySpan seconds whatever the input rate, thinned out to history_capacity samples (one
+    // per ~15 ms with the default, finer than a pixel of the default 10 s plot).
+    enum { MaxHistorySpan = 60 };
+
+    explicit JoystickWidget(std::string title = "Joystick widget", int history_capacity = 4096)
+        : m_title(std::move(title)),
+          m_history(history_capacity, 16, 32, static_cast<float>(MaxHistorySpan))
+    {
+    }
+
+    void set_initial_position(const ImVec2& position)
+    {
+        m_initialPosition = position;
+    }
+
+    // Axis and button changes are recorded into `events`, which is typically shared by all widgets. May be NULL.
+    void set_event_log(JoystickEventLog* events)
+    {
+        m_events = events;
+        if (m_events && m_state.joystick_id >= 0)
+            m_events->set_device_name(m_state.joystick_id, m_state.name.c_str());
+    }
+
     void draw()
     {
-        ImGui::SetNextWindowPos(ImVec2(300, 20));
+        ScopedMemoryTag memory_tag(MemoryTag_Plots);
+        ImGui::SetNextWindowPos(m_initialPosition, ImGuiCond_FirstUseEver);
         ImGui::SetNextWindowSize(ImVec2(500, 600), ImGuiCond_FirstUseEver);
-        ImGui::Begin("Joystick widget");
+        ImGui::Begin(m_title.c_str());
 
-        draw_main_axis_plot(m_state.axes[0], m_state.axes[1]);
+        if (m_state.axes_count >= 2)
+            draw_main_axis_plot(m_state.axes[0], m_state.axes[1]);
+        draw_history_plots();
+        if (ImGui::CollapsingHeader("Statistics"))
+            m_statistics.draw();
+        draw_change_detection_config();
 
         ImGui::End();
-        m_logger.Draw("Joystick widget");
     }
 
-    void update(int axes_count, const float* axes,
-                int button_count, const uint8_t* buttons,
-                const std::string& name, int joystick_id)
+    // Identifies the device the samples passed to update() come from. Only copies the name when it changes.
+    void set_device(int joystick_id, const char* name)
     {
-        m_state.axes.resize(axes_count);
-        //m_state.axes_count = axes_count;
-
         m_state.joystick_id = joystick_id;
-        m_state.name = name;
+        if (m_state.name != name)
+        {
+            m_state.name = name;
+            if (m_events)
+                m_events->set_device_name(joystick_id, name);
+        }
+    }
+
+    // Convenience for callers holding raw glfwGetJoystickAxes()/glfwGetJoystickButtons() data.
+    bool update(int axes_count, const float* axes,
+                int button_count, const uint8_t* buttons,
+                const char* name, int joystick_id, double timestamp)
+    {
+        set_device(joystick_id, name);
 
-        for (int i = 0; i < m_state.axes.size(); ++i) {
-            if (i == 8) continue;
+        JoystickSample sample;
+        sample.set(joystick_id, timestamp, axes_count, axes, button_count, buttons);
+        return update(sample);
+    }
 
-            if (m_state.axes[i] != axes[i] && i != 0 && i != 1)
-                m_logger.AddLog("(%d %s) axis %d = %f\n", m_state.joystick_id, m_state.name.c_str(), i, m_state.axes[i]);
+    // Returns true when any axis or button changed, as seen through the change detection config.
+    bool update(const JoystickSample& sample)
+    {
+        const double timestamp = sample.timestamp;
+        const int joystick_id = m_state.joystick_id;
 
-            m_state.axes[i] = axes[i];
-        }
+        m_history.push(timestamp, sample.axes_count, sample.axes, sample.button_count, sample.buttons);
+        m_statistics.add(sample);
 
-        static ImVec2 prevPoint{ 0, 0 };
-        m_drawingPoints = false;
+        m_state.axes_count = sample.axes_count;
+        m_state.button_count = sample.button_count;
 
-        //m_state.button_count = button_count;
-        m_state.buttons.resize(button_count);
-        for (int i = 0; i < m_state.buttons.size(); ++i)
-        {
-            if (m_state.buttons[i] != buttons[i])
-            {
-                m_logger.AddLog("(%d %s) button %d = %d\n", m_state.joystick_id, m_state.name.c_str(), i,
-                                m_state.buttons[i]);
-            }
+        // Samples are zero padded past their counts.
+        std::memcpy(m_state.axes, sample.axes, sizeof(m_state.axes));
+        if (!m_upstreamDeadzone)
+            state_diff::apply_deadzone(m_state.axes, m_changeConfig.deadzone, JoystickState::MaxAxes);
 
-            m_state.buttons[i] = buttons[i];
+        state_diff::diff_buttons(m_state.buttons, sample.buttons, m_changedButtons, JoystickState::ButtonWords);
+        std::memcpy(m_state.buttons, sample.buttons, sizeof(m_state.buttons));
 
-            if (i == 13 && m_state.buttons[i] == 1)
-            {
-                ImVec2 currentPoint{m_state.axes[0], m_state.axes[1]};
-                m_points.push_back(currentPoint);
-                prevPoint = currentPoint;
-                m_drawingPoints = true;
+        const uint32_t present_axes = m_state.axes_count < 32 ? (1u << m_state.axes_count) - 1u : ~0u;
+        m_changedAxes = state_diff::diff_axes(m_state.axes, m_reportedAxes, m_changeConfig.hysteresis,
+                                              JoystickState::MaxAxes) & present_axes & ~m_changeConfig.ignored_axes;
 
-                continue;
-            }
+        bool changed = m_changedAxes != 0;
+        for (uint32_t mask = m_changedAxes; mask; mask &= mask - 1)
+        {
+            const int i = state_diff::count_trailing_zeros(mask);
+            m_reportedAxes[i] = m_state.axes[i];
+            if (m_events && !(m_changeConfig.unlogged_axes & (1u << i)))
+                m_events->add(timestamp, joystick_id, JoystickEventKind_Axis, i, m_state.axes[i]);
+        }
 
-            if (i == 17 && m_state.buttons[i] == 1)
+        for (int w = 0; w < JoystickState::ButtonWords; ++w)
+        {
+            changed |= m_changedButtons[w] != 0;
+            for (uint32_t mask = m_changedButtons[w]; mask && m_events; mask &= mask - 1)
             {
-                m_points.clear();
-                continue;
+                const int i = w * 32 + state_diff::count_trailing_zeros(mask);
+                m_events->add(timestamp, joystick_id, JoystickEventKind_Button, i, m_state.button(i) ? 1.f : 0.f);
             }
         }
+
+        // Button 13 paints the main stick's position, button 17 clears the canvas.
+        m_drawingPoints = false;
+        if (m_state.button(13) && m_state.axes_count >= 2)
+        {
+            m_paintCanvas.paint(m_state.axes[0], m_state.axes[1]);
+            m_drawingPoints = true;
+        }
+
+        // Cleared once per press, not on every sample while the button is held.
+        if (m_state.button(17) && (m_changedButtons[17 / 32] & (1u << (17 % 32))))
+            m_paintCanvas.clear();
+
+        return changed;
     }
 
+    const JoystickState& state() const { return m_state; }
+    ChangeDetectionConfig& change_config() { return m_changeConfig; }
+    // Set while the samples are already deadzoned upstream (AxisFilterPipeline), so they aren't deadzoned twice.
+    void set_upstream_deadzone(bool upstream) { m_upstreamDeadzone = upstream; }
+    JoystickStatistics& statistics() { return m_statistics; }
+    PaintCanvas& paint_canvas() { return m_paintCanvas; }
+
+    // Axes and buttons reported as changed by the last update().
+    uint32_t changed_axes() const { return m_changedAxes; }
+    const uint32_t* changed_buttons() const { return m_changedButtons; }
+
 private:
     void draw_main_axis_plot(float x, float y)
     {
@@ -93,29 +209,129 @@ private:
         {
             ImPlot::PushStyleVar(ImPlotStyleVar_FillAlpha, 0.25f);
 
+            // The grid goes out as a single item, the path as another one. The marker comes last so the grid, opaque
+            // as a heatmap, doesn't cover it.
+            m_paintCanvas.plot("Printed", "Printed path");
+
             if (!m_drawingPoints)
             {
                 ImPlot::SetNextMarkerStyle(ImPlotMarker_Square, 4, ImVec4(0, 1, 0, 0.5f), IMPLOT_AUTO,
                                            ImVec4(0, 1, 0, 1));
-                ImPlot::PlotScatter("Main axis", &m_state.axes[0], &m_state.axes[1], 1);
+                ImPlot::PlotScatter("Main axis", &x, &y, 1);
             }
+            ImPlot::PopStyleVar();
+            ImPlot::EndPlot();
+        }
+
+        bool exact_points = m_paintCanvas.exact_points();
+        if (ImGui::Checkbox("Keep paint path", &exact_points))
+            m_paintCanvas.set_exact_points(exact_points);
+        if (exact_points)
+        {
+            PolylineSimplifier& simplifier = m_paintCanvas.path_simplifier();
+            float tolerance = simplifier.tolerance();
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(100);
+            if (ImGui::SliderFloat("Tolerance", &tolerance, 0.f, 0.05f, "%.4f"))
+                simplifier.set_tolerance(tolerance);
+        }
+        ImGui::TextDisabled("%d cells painted, %zu path vertices (%.1fx compressed), %zu KiB",
+                            m_paintCanvas.painted_cells(), m_paintCanvas.points().size(),
+                            m_paintCanvas.path_simplifier().compression_ratio(), m_paintCanvas.memory_bytes() / 1024);
+    }
+
+    void draw_change_detection_config()
+    {
+        if (!ImGui::CollapsingHeader("Change detection"))
+            return;
 
-            for(auto point : m_points)
+        if (m_upstreamDeadzone)
+            ImGui::TextDisabled("Deadzones are set in the axis filters (Input window).");
+
+        const bool show_deadzone = !m_upstreamDeadzone;
+        if (ImGui::BeginTable("change_detection", show_deadzone ? 3 : 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Axis");
+            if (show_deadzone)
+                ImGui::TableSetupColumn("Deadzone");
+            ImGui::TableSetupColumn("Hysteresis");
+            ImGui::TableHeadersRow();
+
+            for (int i = 0; i < m_state.axes_count; ++i)
             {
-                ImPlot::SetNextMarkerStyle(ImPlotMarker_Square, 4, ImVec4(1, 0, 0, 0.5f), IMPLOT_AUTO,
-                                           ImVec4(1, 0, 0, 1));
-                ImPlot::PlotScatter("Printed", &point.x, &point.y, 1);
+                ImGui::PushID(i);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d%s", i, (m_changeConfig.ignored_axes & (1u << i)) ? " (ignored)" : "");
+                if (show_deadzone)
+                {
+                    ImGui::TableNextColumn();
+                    ImGui::SetNextItemWidth(-1);
+                    ImGui::SliderFloat("##deadzone", &m_changeConfig.deadzone[i], 0.f, 0.5f, "%.3f");
+                }
+                ImGui::TableNextColumn();
+                ImGui::SetNextItemWidth(-1);
+                ImGui::SliderFloat("##hysteresis", &m_changeConfig.hysteresis[i], 0.f, 0.2f, "%.3f");
+                ImGui::PopID();
             }
-            ImPlot::PopStyleVar();
+            ImGui::EndTable();
+        }
+    }
+
+    void draw_history_plots()
+    {
+        ImGui::SliderFloat("History (s)", &m_historySpan, 1.f, static_cast<float>(MaxHistorySpan), "%.0f");
+
+        const int count = m_history.size();
+        const int offset = m_history.offset();
+        const float* times = m_history.times();
+        const double latest = m_history.latest_time();
+
+        char label[32];
+
+        ImPlot::SetNextPlotLimitsX(latest - m_historySpan, latest, ImGuiCond_Always);
+        ImPlot::SetNextPlotLimitsY(-1.1, 1.1, ImGuiCond_Once);
+        if (ImPlot::BeginPlot("Axes", NULL, NULL, ImVec2(-1, 200)))
+        {
+            for (int i = 0; i < m_history.axes_count(); ++i)
+            {
+                snprintf(label, sizeof(label), "Axis %d", i);
+                ImPlot::PlotLine(label, times, m_history.axis(i), count, offset);
+            }
+            ImPlot::EndPlot();
+        }
+
+        ImPlot::SetNextPlotLimitsX(latest - m_historySpan, latest, ImGuiCond_Always);
+        if (ImPlot::BeginPlot("Buttons", NULL, NULL, ImVec2(-1, 200), ImPlotFlags_None, ImPlotAxisFlags_None,
+                              ImPlotAxisFlags_NoTickLabels))
+        {
+            for (int i = 0; i < m_history.button_count(); ++i)
+            {
+                snprintf(label, sizeof(label), "Button %d", i);
+                ImPlot::PlotDigital(label, times, m_history.button(i), count, offset);
+            }
+            ImPlot::EndPlot();
         }
-        ImPlot::EndPlot();
     }
 
 private:
-    std::vector<ImVec2> m_points;
+    std::string m_title;
+    ImVec2 m_initialPosition{ 300, 20 };
+
+    PaintCanvas m_paintCanvas;
+
+    SampleHistory m_history;
+    float m_historySpan = 10.f;
+    JoystickStatistics m_statistics;
 
     bool m_drawingPoints = false;
 
     JoystickState m_state;
-    ExampleAppLog m_logger;
+    ChangeDetectionConfig m_changeConfig;
+    bool m_upstreamDeadzone = false;
+    alignas(16) float m_reportedAxes[JoystickState::MaxAxes] = {};
+    uint32_t m_changedAxes = 0;
+    alignas(16) uint32_t m_changedButtons[JoystickState::ButtonWords] = {};
+
+    JoystickEventLog* m_events = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "AllocationCounter.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Bounded storage for log lines.
+// Text lives in a fixed number of equally sized chunks used as a ring, and a line never straddles two chunks. When the
+// writer moves on to a chunk that still holds lines, those lines are the oldest ones and get evicted: the chunk is
+// simply reused, nothing is ever moved. Line descriptors are kept in a ring of their own, which gives random access
+// to every live line for ImGuiListClipper, and caps the line count independently of the byte budget.
+//
+// All memory is allocated up front (set_limits()), append() never allocates.
+class LogRingBuffer
+{
+public:
+    LogRingBuffer(int max_lines = 8192, int max_bytes = 256 * 1024, int chunk_size = 16 * 1024)
+    {
+        set_limits(max_lines, max_bytes, chunk_size);
+    }
+
+    // Reallocates the storage, drops every line and resets the counters.
+    void set_limits(int max_lines, int max_bytes, int chunk_size = 16 * 1024)
+    {
+        ScopedMemoryTag tag(MemoryTag_Logger);
+        m_chunkSize = chunk_size > 64 ? chunk_size : 64;
+        const int chunk_count = max_bytes / m_chunkSize;
+        m_chunkLines.assign(chunk_count > 2 ? chunk_count : 2, 0);
+        m_text.assign(m_chunkLines.size() * m_chunkSize, '\0');
+        m_lines.assign(max_lines > 1 ? max_lines : 1, Line());
+
+        m_droppedLines = 0;
+        m_droppedBytes = 0;
+        clear();
+    }
+
+    void clear()
+    {
+        for (int& count : m_chunkLines)
+            count = 0;
+        m_firstLineNumber += m_size;
+        m_first = 0;
+        m_size = 0;
+        m_writeChunk = 0;
+        m_writeOffset = 0;
+    }
+
+    // Appends [text, text_end) as one line per '\n'. A trailing fragment without '\n' is stored as a line of its own.
+    // Lines longer than a chunk are truncated.
+    void append(const char* text, const char* text_end)
+    {
+        while (text < text_end)
+        {
+            const char* newline = static_cast<const char*>(std::memchr(text, '\n', text_end - text));
+            const char* line_end = newline ? newline : text_end;
+            push_line(text, static_cast<int>(line_end - text));
+            text = newline ? newline + 1 : text_end;
+        }
+    }
+
+    int size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    // Line `i` counted from the oldest live line, without its '\n'.
+    const char* line_begin(int i) const { return m_text.data() + line(i).offset; }
+    const char* line_end(int i) const { const Line& l = line(i); return m_text.data() + l.offset + l.length; }
+
+    // Monotonic number of the oldest live line. Line numbers never repeat, even after eviction or clear().
+    uint64_t first_line_number() const { return m_firstLineNumber; }
+
+    uint64_t dropped_lines() const { return m_droppedLines; }
+    uint64_t dropped_bytes() const { return m_droppedBytes; }
+
+    int max_lines() const { return static_cast<int>(m_lines.size()); }
+    size_t capacity_bytes() const { return m_text.size() + m_lines.size() * sizeof(Line); }
+
+private:
+    struct Line
+    {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    const Line& line(int i) const
+    {
+        return m_lines[(m_first + i) % m_lines.size()];
+    }
+
+    void push_line(const char* text, int length)
+    {
+        if (length > m_chunkSize)
+            length = m_chunkSize;
+
+        if (m_writeOffset + length > m_chunkSize)
+        {
+            m_writeChunk = (m_writeChunk + 1) % static_cast<int>(m_chunkLines.size());
+            m_writeOffset = 0;
+
+            // Everything still stored in the chunk we are about to overwrite is older than any other line.
+            while (m_chunkLines[m_writeChunk] > 0)
+                evict_oldest();
+        }
+
+        if (m_size == static_cast<int>(m_lines.size()))
+            evict_oldest();
+
+        Line& l = m_lines[(m_first + m_size) % m_lines.size()];
+        l.offset = static_cast<uint32_t>(m_writeChunk * m_chunkSize + m_writeOffset);
+        l.length = static_cast<uint32_t>(length);
+        std::memcpy(m_text.data() + l.offset, text, length);
+
+        m_writeOffset += length;
+        ++m_chunkLines[m_writeChunk];
+        ++m_size;
+    }
+
+    void evict_oldest()
+    {
+        const Line& l = m_lines[m_first];
+        --m_chunkLines[l.offset / m_chunkSize];
+        ++m_droppedLines;
+        m_droppedBytes += l.length;
+
+        m_first = (m_first + 1) % static_cast<int>(m_lines.size());
+        --m_size;
+        ++m_firstLineNumber;
+    }
+
+private:
+    int m_chunkSize = 0;
+    std::vector<char> m_text;
+    std::vector<int> m_chunkLines; // Live lines per chunk.
+    std::vector<Line> m_lines;
+
+    int m_first = 0;
+    int m_size = 0;
+    int m_writeChunk = 0;
+    int m_writeOffset = 0;
+
+    uint64_t m_firstLineNumber = 0;
+    uint64_t m_droppedLines = 0;
+    uint64_t m_droppedBytes = 0;
+};
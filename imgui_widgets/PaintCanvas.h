@@ -0,0 +1,231 @@
+#pragma once
+
+#include "AllocationCounter.h"
+#include "PolylineSimplifier.h"
+
+#include "imgui.h"
+#include "implot.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Receives the canvas image. The canvas only knows about pixels, the owner of the GL context provides the texture,
+// see GlPaintTexture.h.
+class PaintTexture
+{
+public:
+    virtual ~PaintTexture() {}
+
+    // `rgba` is the whole width x height RGBA8 image, top row first. Rows [first_row, first_row + row_count) changed
+    // since the last upload; the whole image is passed on the first upload.
+    virtual void upload(const uint8_t* rgba, int width, int height, int first_row, int row_count) = 0;
+    virtual ImTextureID texture_id() const = 0;
+};
+
+// The "paint" trail of a joystick, stored as a GridSize x GridSize intensity grid over [-1, 1] x [-1, 1] instead of a
+// list of points. Painting a sample increments one cell (saturating), so memory and draw cost are the same whether
+// someone paints for a second or for an hour, and a resting stick only makes its cell brighter.
+//
+// The grid is drawn as a single image when a PaintTexture is set, only the rows touched since the previous frame are
+// uploaded. Without one (headless builds) it falls back to an ImPlot heatmap.
+//
+// Optionally the painted path is kept too, simplified as it arrives (PolylineSimplifier, within a tolerance in axis
+// units) and drawn as a line over the grid. Its vertices go into a buffer bounded to max_exact_points, when it is full
+// the oldest half is dropped.
+class PaintCanvas
+{
+public:
+    enum { GridSize = 128 };
+
+    explicit PaintCanvas(int max_exact_points = 16384)
+        : m_maxExactPoints(max_exact_points > 2 ? max_exact_points : 2)
+    {
+        ScopedMemoryTag tag(MemoryTag_Plots);
+        m_cells.assign(GridSize * GridSize, 0);
+        m_pixels.assign(GridSize * GridSize * 4, 0);
+    }
+
+    PolylineSimplifier& path_simplifier() { return m_simplifier; }
+    const PolylineSimplifier& path_simplifier() const { return m_simplifier; }
+
+    void set_texture(std::unique_ptr<PaintTexture> texture)
+    {
+        m_texture = std::move(texture);
+        m_textureValid = false;
+    }
+
+    // The path is only collected while enabled, disabling drops it and releases its buffer.
+    void set_exact_points(bool enabled)
+    {
+        m_exactPoints = enabled;
+        if (!enabled)
+        {
+            clear_points();
+            m_points.shrink_to_fit();
+        }
+    }
+    bool exact_points() const { return m_exactPoints; }
+
+    // Keeps the path's buffer, painting again right after doesn't allocate.
+    void clear()
+    {
+        std::memset(m_cells.data(), 0, m_cells.size());
+        std::memset(m_pixels.data(), 0, m_pixels.size());
+        m_paintedCells = 0;
+        m_textureValid = false;
+        clear_points();
+    }
+
+    void paint(float x, float y)
+    {
+        const int row = GridSize - 1 - cell_index(y);
+        const int column = cell_index(x);
+        uint8_t& cell = m_cells[row * GridSize + column];
+        if (cell < 255)
+        {
+            if (cell == 0)
+                ++m_paintedCells;
+            ++cell;
+            set_pixel(row, column, cell);
+            mark_dirty(row);
+        }
+
+        if (m_exactPoints)
+            add_point(x, y);
+    }
+
+    bool empty() const { return m_paintedCells == 0; }
+    int painted_cells() const { return m_paintedCells; }
+
+    // GridSize x GridSize intensities, row-major, top row (y = 1) first.
+    const uint8_t* cells() const { return m_cells.data(); }
+    // Final vertices of the simplified path, without its tail (PolylineSimplifier::tail()).
+    const std::vector<ImVec2>& points() const { return m_points; }
+
+    size_t memory_bytes() const
+    {
+        return m_cells.size() + m_pixels.size() + m_points.capacity() * sizeof(ImVec2);
+    }
+
+    // Draws the trail into the current plot, between ImPlot::BeginPlot() and ImPlot::EndPlot(): the grid as
+    // `grid_label`, the path over it as `path_label`.
+    void plot(const char* grid_label, const char* path_label)
+    {
+        if (empty())
+            return;
+
+        if (m_texture)
+            plot_texture(grid_label);
+        else
+            plot_heatmap(grid_label);
+
+        if (m_exactPoints && !m_points.empty())
+            plot_points(path_label);
+    }
+
+private:
+    static int cell_index(float value)
+    {
+        const int index = static_cast<int>((value + 1.f) * 0.5f * GridSize);
+        return index < 0 ? 0 : (index >= GridSize ? GridSize - 1 : index);
+    }
+
+    // Red, more opaque the longer the stick stayed in the cell. Empty cells are transparent.
+    void set_pixel(int row, int column, uint8_t intensity)
+    {
+        uint8_t* pixel = &m_pixels[(row * GridSize + column) * 4];
+        pixel[0] = 255;
+        pixel[1] = 0;
+        pixel[2] = 0;
+        pixel[3] = static_cast<uint8_t>(96 + intensity * 159 / 255);
+    }
+
+    void mark_dirty(int row)
+    {
+        if (m_dirtyFirstRow > row)
+            m_dirtyFirstRow = row;
+        if (m_dirtyLastRow < row)
+            m_dirtyLastRow = row;
+    }
+
+    void add_point(float x, float y)
+    {
+        ImVec2 vertex;
+        if (!m_simplifier.add(ImVec2(x, y), vertex))
+            return;
+
+        if (static_cast<int>(m_points.size()) == m_maxExactPoints)
+            m_points.erase(m_points.begin(), m_points.begin() + m_maxExactPoints / 2);
+        if (m_points.capacity() == 0)
+        {
+            ScopedMemoryTag tag(MemoryTag_Plots);
+            m_points.reserve(m_maxExactPoints + 1); // + 1 for the tail while plotting.
+        }
+        m_points.push_back(vertex);
+    }
+
+    void clear_points()
+    {
+        m_points.clear();
+        m_simplifier.reset();
+    }
+
+    void plot_points(const char* label)
+    {
+        // The tail goes in temporarily, there is room reserved for it.
+        if (m_simplifier.has_tail())
+            m_points.push_back(m_simplifier.tail());
+
+        ImPlot::SetNextLineStyle(ImVec4(1, 0, 0, 1));
+        ImPlot::PlotLine(label, &m_points[0].x, &m_points[0].y, static_cast<int>(m_points.size()), 0, sizeof(ImVec2));
+
+        if (m_simplifier.has_tail())
+            m_points.pop_back();
+    }
+
+    void plot_texture(const char* label)
+    {
+        if (!m_textureValid)
+        {
+            m_texture->upload(m_pixels.data(), GridSize, GridSize, 0, GridSize);
+            m_textureValid = true;
+        }
+        else if (m_dirtyFirstRow <= m_dirtyLastRow)
+        {
+            m_texture->upload(m_pixels.data(), GridSize, GridSize, m_dirtyFirstRow,
+                              m_dirtyLastRow - m_dirtyFirstRow + 1);
+        }
+        m_dirtyFirstRow = GridSize;
+        m_dirtyLastRow = -1;
+
+        ImPlot::PlotImage(label, m_texture->texture_id(), ImPlotPoint(-1, -1), ImPlotPoint(1, 1));
+    }
+
+    void plot_heatmap(const char* label)
+    {
+        ImPlot::PushColormap(ImPlotColormap_Hot);
+        ImPlot::PlotHeatmap(label, m_cells.data(), GridSize, GridSize, 0.0, 255.0, NULL, ImPlotPoint(-1, -1),
+                            ImPlotPoint(1, 1));
+        ImPlot::PopColormap();
+    }
+
+private:
+    int m_maxExactPoints;
+    bool m_exactPoints = false;
+
+    std::vector<uint8_t> m_cells;
+    int m_paintedCells = 0;
+
+    // RGBA8 image of m_cells for the texture, and the range of rows changed since the last upload.
+    std::vector<uint8_t> m_pixels;
+    int m_dirtyFirstRow = GridSize;
+    int m_dirtyLastRow = -1;
+    std::unique_ptr<PaintTexture> m_texture;
+    bool m_textureValid = false;
+
+    std::vector<ImVec2> m_points;
+    PolylineSimplifier m_simplifier;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <cstdint>
+
+// Online polyline simplification for paths that arrive one point at a time (an "opening window" variant of
+// Ramer-Douglas-Peucker). The last emitted vertex is the anchor; following points are collected in a window as long
+// as all of them lie within `tolerance` of the segment from the anchor to the newest point. When a point breaks that,
+// or the window is full, the previous point becomes the next vertex and the next anchor. Points within `tolerance` of
+// the anchor are dropped before that, so a stick resting on a vertex doesn't fill the window. Every input point ends
+// up within `tolerance` of the output path.
+//
+// Holds and straight sweeps collapse into single segments, turns keep their vertices. Every point is checked against
+// at most max_window pending points, and no input is stored beyond the window.
+class PolylineSimplifier
+{
+public:
+    enum { MaxWindow = 64 };
+
+    explicit PolylineSimplifier(float tolerance = 0.005f, int max_window = MaxWindow)
+        : m_tolerance(tolerance),
+          m_maxWindow(max_window < 1 ? 1 : (max_window > MaxWindow ? static_cast<int>(MaxWindow) : max_window))
+    {
+    }
+
+    // Applies to the points added from now on.
+    void set_tolerance(float tolerance) { m_tolerance = tolerance > 0.f ? tolerance : 0.f; }
+    float tolerance() const { return m_tolerance; }
+
+    void reset()
+    {
+        m_hasAnchor = false;
+        m_windowSize = 0;
+        m_inputCount = 0;
+        m_outputCount = 0;
+    }
+
+    // Returns true when the path gained a final vertex, written to `vertex`. The first point always is one.
+    bool add(const ImVec2& point, ImVec2& vertex)
+    {
+        ++m_inputCount;
+        if (!m_hasAnchor)
+        {
+            m_anchor = vertex = point;
+            m_hasAnchor = true;
+            ++m_outputCount;
+            return true;
+        }
+
+        // The anchor stays a vertex whatever comes next, so this can't move the path further than the tolerance.
+        const float dx = point.x - m_anchor.x;
+        const float dy = point.y - m_anchor.y;
+        if (dx * dx + dy * dy <= m_tolerance * m_tolerance)
+            return false;
+
+        if (m_windowSize < m_maxWindow && window_fits(point))
+        {
+            m_window[m_windowSize++] = point;
+            return false;
+        }
+
+        m_anchor = vertex = m_window[m_windowSize - 1];
+        m_window[0] = point;
+        m_windowSize = 1;
+        ++m_outputCount;
+        return true;
+    }
+
+    // The newest point, where the path currently ends. It is not a final vertex yet and may still be replaced.
+    bool has_tail() const { return m_windowSize > 0; }
+    const ImVec2& tail() const { return m_window[m_windowSize - 1]; }
+
+    uint64_t input_count() const { return m_inputCount; }
+    // Final vertices, the tail not included.
+    uint64_t output_count() const { return m_outputCount; }
+    double compression_ratio() const
+    {
+        const uint64_t output = m_outputCount + (has_tail() ? 1 : 0);
+        return output ? static_cast<double>(m_inputCount) / output : 1.0;
+    }
+
+private:
+    // Whether every pending point is within the tolerance of the segment anchor -> end.
+    bool window_fits(const ImVec2& end) const
+    {
+        const float dx = end.x - m_anchor.x;
+        const float dy = end.y - m_anchor.y;
+        const float length_squared = dx * dx + dy * dy;
+        const float tolerance_squared = m_tolerance * m_tolerance;
+
+        for (int i = 0; i < m_windowSize; ++i)
+        {
+            const ImVec2& p = m_window[i];
+            float t = length_squared > 0.f ? ((p.x - m_anchor.x) * dx + (p.y - m_anchor.y) * dy) / length_squared : 0.f;
+            t = t < 0.f ? 0.f : (t > 1.f ? 1.f : t);
+            const float ex = m_anchor.x + t * dx - p.x;
+            const float ey = m_anchor.y + t * dy - p.y;
+            if (ex * ex + ey * ey > tolerance_squared)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    float m_tolerance;
+    int m_maxWindow;
+
+    bool m_hasAnchor = false;
+    ImVec2 m_anchor;
+    ImVec2 m_window[MaxWindow];
+    int m_windowSize = 0;
+
+    uint64_t m_inputCount = 0;
+    uint64_t m_outputCount = 0;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+// Decides, once per main loop iteration, whether a frame needs to be built and presented at all. A frame is rendered
+// when something reported activity since the last rendered frame (joystick changes, mouse and keyboard input, device
+// hotplug, window resizes), for a few frames after that so ImGui can settle hover states and window layout, and at
+// least every refresh interval so time-based content (history plots, text cursors) doesn't freeze completely.
+//
+// Skipped iterations still have to drain input, only building and submitting the frame is skipped. In the browser
+// a requestAnimationFrame callback that draws nothing leaves the canvas as it was, so the last frame stays on screen.
+class RenderThrottle
+{
+public:
+    enum { SettleFrames = 3 };
+
+    void set_enabled(bool enabled)
+    {
+        m_enabled = enabled;
+        m_settleFrames = SettleFrames;
+    }
+
+    bool enabled() const { return m_enabled; }
+
+    void set_refresh_interval(double seconds) { m_refreshInterval = seconds; }
+    double refresh_interval() const { return m_refreshInterval; }
+
+    // Can be called at any time, including from input callbacks between frames.
+    void notify_activity()
+    {
+        m_settleFrames = SettleFrames;
+    }
+
+    bool should_render(double now)
+    {
+        const bool render = !m_enabled || m_settleFrames > 0 || now - m_lastRender >= m_refreshInterval;
+        if (render)
+        {
+            if (m_settleFrames > 0)
+                --m_settleFrames;
+            m_lastRender = now;
+            ++m_rendered;
+        }
+        else
+        {
+            ++m_skipped;
+        }
+        return render;
+    }
+
+    uint64_t rendered() const { return m_rendered; }
+    uint64_t skipped() const { return m_skipped; }
+
+private:
+    bool m_enabled = true;
+    double m_refreshInterval = 0.5;
+    double m_lastRender = -1e9;
+    int m_settleFrames = SettleFrames;
+    uint64_t m_rendered = 0;
+    uint64_t m_skipped = 0;
+};
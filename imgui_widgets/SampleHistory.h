@@ -0,0 +1,134 @@
+#pragma once
+
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity ring buffer of timestamped joystick samples, stored as one column per axis/button (struct of arrays)
+// so every column can be handed to ImPlot directly through its offset/stride arguments.
+// All storage is allocated in the constructor, push() never allocates.
+//
+// With a `max_span` the samples are thinned out so the capacity covers that many seconds at any input rate: until the
+// newest sample is max_span / capacity younger than the one before it, new samples replace it instead of being
+// appended. The newest sample is always the latest input, and a sample whose buttons differ from the newest one is
+// always appended so no press gets lost.
+class SampleHistory
+{
+public:
+    // Times are floats relative to origin(). The origin moves forward by this much whenever the times reach it, which
+    // keeps their resolution finer than 0.1 ms however long the session runs.
+    enum { RebaseSeconds = 1024 };
+
+    explicit SampleHistory(int capacity = 2048, int max_axes = 16, int max_buttons = 32, float max_span = 0.f)
+        : m_capacity(capacity > 1 ? capacity : 2),
+          m_maxAxes(max_axes),
+          m_maxButtons(max_buttons),
+          m_minInterval(max_span > 0.f ? max_span / (m_capacity - 1) : 0.f)
+    {
+        ScopedMemoryTag tag(MemoryTag_History);
+        m_times.resize(m_capacity);
+        m_axes.resize(static_cast<size_t>(m_capacity) * max_axes);
+        m_buttons.resize(static_cast<size_t>(m_capacity) * max_buttons);
+        m_newestButtons.resize((max_buttons + 31) / 32);
+    }
+
+    // `buttons` holds one bit per button.
+    void push(double timestamp, int axes_count, const float* axes, int button_count, const uint32_t* buttons)
+    {
+        if (m_size == 0)
+            m_origin = timestamp;
+        else if (timestamp - m_origin >= RebaseSeconds)
+            rebase(std::floor((timestamp - m_origin) / RebaseSeconds) * RebaseSeconds);
+
+        m_axesCount = axes_count < m_maxAxes ? axes_count : m_maxAxes;
+        m_buttonCount = button_count < m_maxButtons ? button_count : m_maxButtons;
+
+        const float time = static_cast<float>(timestamp - m_origin);
+        const bool buttons_changed = update_newest_buttons(buttons);
+        int slot = m_head;
+        if (m_size >= 2 && !buttons_changed && m_times[index(1)] - m_times[index(2)] < m_minInterval)
+            slot = index(1);
+
+        m_times[slot] = time;
+        for (int i = 0; i < m_axesCount; ++i)
+            m_axes[static_cast<size_t>(i) * m_capacity + slot] = axes[i];
+        for (int i = 0; i < m_buttonCount; ++i)
+            m_buttons[static_cast<size_t>(i) * m_capacity + slot] = static_cast<float>((buttons[i / 32] >> (i % 32)) & 1u);
+
+        if (slot != m_head)
+            return;
+        m_head = (m_head + 1) % m_capacity;
+        if (m_size < m_capacity)
+            ++m_size;
+    }
+
+    void clear()
+    {
+        m_head = 0;
+        m_size = 0;
+        std::fill(m_newestButtons.begin(), m_newestButtons.end(), 0u);
+    }
+
+    int size() const { return m_size; }
+    int capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+
+    // Storage index of the oldest sample, to be passed as ImPlot's offset argument together with size().
+    int offset() const { return m_size < m_capacity ? 0 : m_head; }
+
+    int axes_count() const { return m_axesCount; }
+    int button_count() const { return m_buttonCount; }
+
+    // Absolute timestamp the relative sample times are measured from.
+    double origin() const { return m_origin; }
+    float latest_time() const { return m_size ? m_times[index(1)] : 0.f; }
+
+    const float* times() const { return m_times.data(); }
+    const float* axis(int i) const { return m_axes.data() + static_cast<size_t>(i) * m_capacity; }
+    const float* button(int i) const { return m_buttons.data() + static_cast<size_t>(i) * m_capacity; }
+
+private:
+    // Storage index of the n-th newest sample, 1 being the newest.
+    int index(int n) const { return (m_head + m_capacity - n) % m_capacity; }
+
+    // Remembers the buttons of the sample being pushed, returns whether any shown one differs from the previous push.
+    bool update_newest_buttons(const uint32_t* buttons)
+    {
+        bool changed = false;
+        for (int w = 0; w * 32 < m_buttonCount; ++w)
+        {
+            const int bits = m_buttonCount - w * 32;
+            const uint32_t mask = bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1u;
+            changed |= ((buttons[w] ^ m_newestButtons[w]) & mask) != 0;
+            m_newestButtons[w] = buttons[w] & mask;
+        }
+        return changed;
+    }
+
+    void rebase(double shift)
+    {
+        m_origin += shift;
+        for (float& time : m_times)
+            time = static_cast<float>(time - shift);
+    }
+
+private:
+    int m_capacity;
+    int m_maxAxes;
+    int m_maxButtons;
+    float m_minInterval;
+
+    std::vector<float> m_times;
+    std::vector<float> m_axes;
+    std::vector<float> m_buttons;
+    std::vector<uint32_t> m_newestButtons;
+
+    int m_head = 0;
+    int m_size = 0;
+    int m_axesCount = 0;
+    int m_buttonCount = 0;
+    double m_origin = 0;
+};
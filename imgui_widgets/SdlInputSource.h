@@ -0,0 +1,365 @@
+#pragma once
+
+#include "Clock.h"
+#include "DeviceRegistry.h"
+#include "InputSource.h"
+
+#include "imgui.h"
+
+#include <SDL.h>
+
+#include <cstring>
+
+// Event-driven joystick source. Every SDL joystick event becomes a sample of its device, stamped with the event's SDL
+// timestamp, so intermediate values between two frames are kept instead of only the state at frame time. Consecutive
+// events of one device with the same timestamp (e.g. X and Y moving together) are merged into a single sample, as long
+// as none of them changes an axis or button the sample already has a change of: SDL timestamps are milliseconds, a
+// second value of the same axis within one goes into a sample of its own so none is lost.
+//
+// Samples still pending when their device is removed are dropped, they would otherwise be delivered after the
+// disconnect, possibly attributed to a new device in the same slot.
+//
+// Pending samples keep the raw int16 axis values, they are converted to floats in one batch per poll().
+// Hats are reported as four extra buttons each (up, right, down, left), after the regular buttons, like GLFW does.
+//
+// The main loop passes every SDL event to process_event() from its SDL_PollEvent loop.
+class SdlInputSource : public InputSource
+{
+public:
+    enum { MaxPending = 1024 };
+
+    ~SdlInputSource()
+    {
+        stop();
+    }
+
+    const char* name() const override { return "SDL"; }
+
+    // SDL sends an SDL_JOYDEVICEADDED event for every joystick present at startup, they are reported from there.
+    void start(InputListener* listener) override
+    {
+        m_listener = listener;
+        m_tickOffset = now_seconds() - SDL_GetTicks() * 1e-3;
+        SDL_JoystickEventState(SDL_ENABLE);
+    }
+
+    void stop() override
+    {
+        for (Device& device : m_devices)
+        {
+            if (device.joystick)
+                SDL_JoystickClose(device.joystick);
+            device = Device();
+        }
+        m_pendingCount = m_pendingRead = 0;
+    }
+
+    // Returns whether the event was a joystick event.
+    bool process_event(const SDL_Event& event)
+    {
+        switch (event.type)
+        {
+        case SDL_JOYDEVICEADDED:
+            open_device(event.jdevice.which, event.jdevice.timestamp);
+            return true;
+
+        case SDL_JOYDEVICEREMOVED:
+            close_device(event.jdevice.which);
+            return true;
+
+        case SDL_JOYAXISMOTION:
+        {
+            const int slot = find_slot(event.jaxis.which);
+            if (slot >= 0 && event.jaxis.axis < m_devices[slot].axes_count)
+            {
+                m_devices[slot].axes[event.jaxis.axis] = event.jaxis.value;
+                push_pending(slot, event.jaxis.timestamp, 1u << event.jaxis.axis, event.jaxis.axis, 0);
+            }
+            return true;
+        }
+
+        case SDL_JOYBUTTONDOWN:
+        case SDL_JOYBUTTONUP:
+        {
+            const int slot = find_slot(event.jbutton.which);
+            if (slot >= 0 && event.jbutton.button < m_devices[slot].regular_buttons)
+            {
+                set_button(m_devices[slot], event.jbutton.button, event.jbutton.state == SDL_PRESSED);
+                push_pending(slot, event.jbutton.timestamp, 0, event.jbutton.button, 1);
+            }
+            return true;
+        }
+
+        case SDL_JOYHATMOTION:
+        {
+            const int slot = find_slot(event.jhat.which);
+            if (slot >= 0)
+            {
+                set_hat(m_devices[slot], event.jhat.hat, event.jhat.value);
+                push_pending(slot, event.jhat.timestamp, 0, m_devices[slot].regular_buttons + event.jhat.hat * 4, 4);
+            }
+            return true;
+        }
+
+        case SDL_JOYBALLMOTION:
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    int poll(JoystickSample* samples, int max_samples) override
+    {
+        const int available = m_pendingCount - m_pendingRead;
+        const int count = available < max_samples ? available : max_samples;
+        if (count <= 0)
+        {
+            m_pendingCount = m_pendingRead = 0;
+            return 0;
+        }
+
+        normalize_axes(&m_pendingAxes[0][0] + m_pendingRead * JoystickSample::MaxAxes, &m_normalized[0][0],
+                       count * JoystickSample::MaxAxes);
+
+        for (int i = 0; i < count; ++i)
+        {
+            const Pending& pending = m_pending[m_pendingRead + i];
+            JoystickSample& sample = samples[i];
+            sample.timestamp = pending.timestamp;
+            sample.joystick_id = pending.joystick_id;
+            sample.axes_count = pending.axes_count;
+            sample.button_count = pending.button_count;
+            std::memcpy(sample.axes, m_normalized[i], sizeof(sample.axes));
+            std::memcpy(sample.buttons, pending.buttons, sizeof(sample.buttons));
+        }
+
+        m_pendingRead += count;
+        if (m_pendingRead == m_pendingCount)
+            m_pendingCount = m_pendingRead = 0;
+        m_delivered += count;
+        return count;
+    }
+
+    uint64_t dropped() const override { return m_dropped; }
+
+    void draw_status() const override
+    {
+        ImGui::Text("SDL, event driven");
+        ImGui::Text("%llu events, %llu samples, %llu dropped", (unsigned long long)m_events,
+                    (unsigned long long)m_delivered, (unsigned long long)m_dropped);
+    }
+
+private:
+    struct Device
+    {
+        SDL_Joystick* joystick = NULL;
+        SDL_JoystickID instance_id = -1;
+        int axes_count = 0;
+        int regular_buttons = 0;
+        int button_count = 0;
+        int16_t axes[JoystickSample::MaxAxes] = {};
+        uint32_t buttons[JoystickSample::ButtonWords] = {};
+    };
+
+    struct Pending
+    {
+        double timestamp;
+        Uint32 ticks;
+        int joystick_id;
+        int axes_count;
+        int button_count;
+        uint32_t buttons[JoystickSample::ButtonWords];
+        // What the events merged into this sample changed, a further change of any of it starts a new sample.
+        uint32_t changed_axes;
+        uint32_t changed_buttons[JoystickSample::ButtonWords];
+    };
+
+    // Maps int16 axis values to [-1, 1], 0 stays exactly 0. A plain loop over the whole batch, which the compiler
+    // vectorises (SSE2, NEON, and wasm SIMD128 when built with -msimd128).
+    static void normalize_axes(const int16_t* values, float* out, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            const float value = values[i] * (1.f / 32767.f);
+            out[i] = value < -1.f ? -1.f : value;
+        }
+    }
+
+    static void set_button(Device& device, int button, bool pressed)
+    {
+        const uint32_t bit = 1u << (button % 32);
+        if (pressed)
+            device.buttons[button / 32] |= bit;
+        else
+            device.buttons[button / 32] &= ~bit;
+    }
+
+    static void set_hat(Device& device, int hat, Uint8 value)
+    {
+        const int first = device.regular_buttons + hat * 4;
+        const Uint8 directions[4] = { SDL_HAT_UP, SDL_HAT_RIGHT, SDL_HAT_DOWN, SDL_HAT_LEFT };
+        for (int i = 0; i < 4 && first + i < device.button_count; ++i)
+            set_button(device, first + i, (value & directions[i]) != 0);
+    }
+
+    int find_slot(SDL_JoystickID instance_id) const
+    {
+        for (int slot = 0; slot < DeviceRegistry::MaxDevices; ++slot)
+        {
+            if (m_devices[slot].joystick && m_devices[slot].instance_id == instance_id)
+                return slot;
+        }
+        return -1;
+    }
+
+    void open_device(int device_index, Uint32 ticks)
+    {
+        SDL_Joystick* joystick = SDL_JoystickOpen(device_index);
+        if (!joystick)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_JoystickOpen(%d) failed: %s\n", device_index, SDL_GetError());
+            return;
+        }
+
+        // Opening an already open device only adds a reference.
+        const SDL_JoystickID instance_id = SDL_JoystickInstanceID(joystick);
+        int slot = find_slot(instance_id);
+        if (slot >= 0)
+        {
+            SDL_JoystickClose(joystick);
+            return;
+        }
+
+        slot = 0;
+        while (slot < DeviceRegistry::MaxDevices && m_devices[slot].joystick)
+            ++slot;
+        if (slot == DeviceRegistry::MaxDevices)
+        {
+            SDL_JoystickClose(joystick);
+            return;
+        }
+
+        Device& device = m_devices[slot];
+        device = Device();
+        device.joystick = joystick;
+        device.instance_id = instance_id;
+
+        const int axes_count = SDL_JoystickNumAxes(joystick);
+        device.axes_count = axes_count < JoystickSample::MaxAxes ? axes_count : static_cast<int>(JoystickSample::MaxAxes);
+        const int regular_buttons = SDL_JoystickNumButtons(joystick);
+        device.regular_buttons = regular_buttons < JoystickSample::MaxButtons ? regular_buttons
+                                                                               : static_cast<int>(JoystickSample::MaxButtons);
+        const int button_count = device.regular_buttons + 4 * SDL_JoystickNumHats(joystick);
+        device.button_count = button_count < JoystickSample::MaxButtons ? button_count
+                                                                         : static_cast<int>(JoystickSample::MaxButtons);
+
+        // Start from the current state, events only report changes.
+        for (int i = 0; i < device.axes_count; ++i)
+            device.axes[i] = SDL_JoystickGetAxis(joystick, i);
+        for (int i = 0; i < device.regular_buttons; ++i)
+            set_button(device, i, SDL_JoystickGetButton(joystick, i) != 0);
+        for (int i = 0; i < SDL_JoystickNumHats(joystick); ++i)
+            set_hat(device, i, SDL_JoystickGetHat(joystick, i));
+
+        const char* name = SDL_JoystickName(joystick);
+        m_listener->device_connected(slot, name ? name : "");
+        push_pending(slot, ticks, 0, 0, 0);
+    }
+
+    void close_device(SDL_JoystickID instance_id)
+    {
+        const int slot = find_slot(instance_id);
+        if (slot < 0)
+            return;
+
+        SDL_JoystickClose(m_devices[slot].joystick);
+        m_devices[slot] = Device();
+        drop_pending(slot);
+        m_listener->device_disconnected(slot);
+    }
+
+    // Removes the samples of `slot` that poll() hasn't handed out yet, keeping the order of the others.
+    void drop_pending(int slot)
+    {
+        int kept = m_pendingRead;
+        for (int i = m_pendingRead; i < m_pendingCount; ++i)
+        {
+            if (m_pending[i].joystick_id == slot)
+                continue;
+            if (kept != i)
+            {
+                m_pending[kept] = m_pending[i];
+                std::memcpy(m_pendingAxes[kept], m_pendingAxes[i], sizeof(m_pendingAxes[i]));
+            }
+            ++kept;
+        }
+        m_pendingCount = kept;
+    }
+
+    // Whether the pending sample already has a change of the axes in `axes` or of the buttons [first_button,
+    // first_button + button_count).
+    static bool overlaps(const Pending& pending, uint32_t axes, int first_button, int button_count)
+    {
+        if (pending.changed_axes & axes)
+            return true;
+        for (int i = first_button; i < first_button + button_count && i < JoystickSample::MaxButtons; ++i)
+        {
+            if (pending.changed_buttons[i / 32] & (1u << (i % 32)))
+                return true;
+        }
+        return false;
+    }
+
+    // Queues the device's state after an event that changed the axes in `changed_axes` and the buttons
+    // [first_button, first_button + button_count).
+    void push_pending(int slot, Uint32 ticks, uint32_t changed_axes, int first_button, int button_count)
+    {
+        ++m_events;
+
+        int index = m_pendingCount - 1;
+        const bool merge = index >= m_pendingRead && m_pending[index].joystick_id == slot &&
+                           m_pending[index].ticks == ticks &&
+                           !overlaps(m_pending[index], changed_axes, first_button, button_count);
+        if (!merge)
+        {
+            if (m_pendingCount == MaxPending)
+            {
+                ++m_dropped;
+                return;
+            }
+            index = m_pendingCount++;
+            m_pending[index].changed_axes = 0;
+            std::memset(m_pending[index].changed_buttons, 0, sizeof(m_pending[index].changed_buttons));
+        }
+
+        const Device& device = m_devices[slot];
+        Pending& pending = m_pending[index];
+        pending.changed_axes |= changed_axes;
+        for (int i = first_button; i < first_button + button_count && i < JoystickSample::MaxButtons; ++i)
+            pending.changed_buttons[i / 32] |= 1u << (i % 32);
+        pending.timestamp = m_tickOffset + ticks * 1e-3;
+        pending.ticks = ticks;
+        pending.joystick_id = slot;
+        pending.axes_count = device.axes_count;
+        pending.button_count = device.button_count;
+        std::memcpy(pending.buttons, device.buttons, sizeof(pending.buttons));
+        std::memcpy(m_pendingAxes[index], device.axes, sizeof(device.axes));
+    }
+
+private:
+    InputListener* m_listener = NULL;
+    // Converts SDL ticks (milliseconds since SDL_Init) to now_seconds() time.
+    double m_tickOffset = 0;
+    Device m_devices[DeviceRegistry::MaxDevices];
+
+    Pending m_pending[MaxPending];
+    int16_t m_pendingAxes[MaxPending][JoystickSample::MaxAxes];
+    float m_normalized[MaxPending][JoystickSample::MaxAxes];
+    int m_pendingCount = 0;
+    int m_pendingRead = 0;
+
+    uint64_t m_events = 0;
+    uint64_t m_delivered = 0;
+    uint64_t m_dropped = 0;
+};
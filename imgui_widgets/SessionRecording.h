@@ -0,0 +1,471 @@
+#pragma once
+
+#include "AllocationCounter.h"
+#include "JoystickSample.h"
+#include "StateDiff.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JOYSTICK_SESSION_MMAP 1
+#endif
+
+// Compact binary recording of joystick sessions.
+//
+// A recording is a header ("JSR", format version) followed by one record per JoystickSample:
+//   varint   time since the previous record, in microseconds
+//   byte     device id (bits 0-3) | counts follow (bit 4) | axes follow (bit 5) | buttons follow (bit 6)
+//   [counts]  byte axes count, byte button count, only when they changed
+//   [axes]    varint mask of changed axes, then one zigzag varint per changed axis: the delta of the axis value
+//             quantized to 16 bits against the previous value of the same axis on the same device
+//   [buttons] byte mask of changed 32-bit button words, then one varint per changed word: old bits XOR new bits
+// An idle device costs 3 bytes per sample, a single moving axis about 5.
+namespace session_recording
+{
+
+enum
+{
+    FormatVersion = 1,
+    HeaderSize = 4,
+    MaxDevices = 16,
+    Flag_Counts = 1 << 4,
+    Flag_Axes = 1 << 5,
+    Flag_Buttons = 1 << 6,
+    // Worst case of one record: time, flags, counts, 16 axes and 4 button words.
+    MaxRecordSize = 10 + 1 + 2 + 3 + 16 * 3 + 1 + 4 * 5,
+};
+
+inline void write_varint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline bool read_varint(const uint8_t*& data, const uint8_t* end, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && data < end; shift += 7)
+    {
+        const uint8_t byte = *data++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+inline uint32_t zigzag_encode(int32_t value)
+{
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+inline int32_t zigzag_decode(uint32_t value)
+{
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+inline int16_t quantize_axis(float value)
+{
+    const float clamped = value < -1.f ? -1.f : (value > 1.f ? 1.f : value);
+    return static_cast<int16_t>(std::lrint(clamped * 32767.f));
+}
+
+inline float dequantize_axis(int32_t value)
+{
+    return static_cast<float>(value) * (1.f / 32767.f);
+}
+
+// Per-device state both sides delta-encode against.
+struct DeviceState
+{
+    bool known = false;
+    int axes_count = 0;
+    int button_count = 0;
+    int16_t axes[JoystickSample::MaxAxes] = {};
+    uint32_t buttons[JoystickSample::ButtonWords] = {};
+};
+
+} // namespace session_recording
+
+// Encodes samples into an in-memory recording. Works the same in the browser (no filesystem) and natively, where
+// save() can write the result to disk.
+class SessionRecorder
+{
+public:
+    // Caps the recording at `max_bytes`, 0 for no limit. begin() then reserves the whole buffer, so recording doesn't
+    // allocate, and the recording ends by itself once the next sample might not fit anymore, see full().
+    void set_max_bytes(size_t max_bytes) { m_maxBytes = max_bytes; }
+    size_t max_bytes() const { return m_maxBytes; }
+
+    void begin()
+    {
+        ScopedMemoryTag tag(MemoryTag_Recording);
+        m_data.clear();
+        if (m_maxBytes > m_data.capacity())
+            m_data.reserve(m_maxBytes);
+        m_full = false;
+        m_data.push_back('J');
+        m_data.push_back('S');
+        m_data.push_back('R');
+        m_data.push_back(session_recording::FormatVersion);
+        for (session_recording::DeviceState& device : m_devices)
+            device = session_recording::DeviceState();
+        m_lastTimestamp = -1;
+        m_sampleCount = 0;
+        m_recording = true;
+    }
+
+    void end()
+    {
+        m_recording = false;
+    }
+
+    bool is_recording() const { return m_recording; }
+    // Whether the last recording ended because it reached max_bytes().
+    bool full() const { return m_full; }
+
+    void record(const JoystickSample& sample)
+    {
+        using namespace session_recording;
+        if (!m_recording || sample.joystick_id < 0 || sample.joystick_id >= MaxDevices)
+            return;
+        if (m_maxBytes && m_data.size() + MaxRecordSize > m_maxBytes)
+        {
+            m_recording = false;
+            m_full = true;
+            return;
+        }
+        ScopedMemoryTag tag(MemoryTag_Recording);
+
+        const double timestamp = sample.timestamp;
+        const double delta = m_lastTimestamp < 0 ? 0.0 : timestamp - m_lastTimestamp;
+        const uint64_t delta_us = delta > 0 ? static_cast<uint64_t>(delta * 1e6 + 0.5) : 0;
+        // Accumulate the rounded value so rounding errors don't add up over long recordings. Time going backwards (a
+        // different clock, e.g. several bench scenarios in one recording) is recorded as no time passing.
+        m_lastTimestamp = delta > 0 ? m_lastTimestamp + delta_us * 1e-6 : timestamp;
+
+        DeviceState& device = m_devices[sample.joystick_id];
+
+        uint8_t flags = static_cast<uint8_t>(sample.joystick_id);
+        if (!device.known || device.axes_count != sample.axes_count || device.button_count != sample.button_count)
+            flags |= Flag_Counts;
+
+        uint32_t axis_mask = 0;
+        int16_t axes[JoystickSample::MaxAxes];
+        for (int i = 0; i < sample.axes_count; ++i)
+        {
+            axes[i] = quantize_axis(sample.axes[i]);
+            if (axes[i] != device.axes[i])
+                axis_mask |= 1u << i;
+        }
+        if (axis_mask)
+            flags |= Flag_Axes;
+
+        uint8_t word_mask = 0;
+        for (int w = 0; w < JoystickSample::ButtonWords; ++w)
+        {
+            if (sample.buttons[w] != device.buttons[w])
+                word_mask |= 1u << w;
+        }
+        if (word_mask)
+            flags |= Flag_Buttons;
+
+        write_varint(m_data, delta_us);
+        m_data.push_back(flags);
+        if (flags & Flag_Counts)
+        {
+            m_data.push_back(static_cast<uint8_t>(sample.axes_count));
+            m_data.push_back(static_cast<uint8_t>(sample.button_count));
+        }
+        if (flags & Flag_Axes)
+        {
+            write_varint(m_data, axis_mask);
+            for (uint32_t mask = axis_mask; mask; mask &= mask - 1)
+            {
+                const int i = state_diff::count_trailing_zeros(mask);
+                write_varint(m_data, zigzag_encode(axes[i] - device.axes[i]));
+                device.axes[i] = axes[i];
+            }
+        }
+        if (flags & Flag_Buttons)
+        {
+            m_data.push_back(word_mask);
+            for (int w = 0; w < JoystickSample::ButtonWords; ++w)
+            {
+                if (word_mask & (1u << w))
+                {
+                    write_varint(m_data, device.buttons[w] ^ sample.buttons[w]);
+                    device.buttons[w] = sample.buttons[w];
+                }
+            }
+        }
+
+        device.known = true;
+        device.axes_count = sample.axes_count;
+        device.button_count = sample.button_count;
+        ++m_sampleCount;
+    }
+
+    const std::vector<uint8_t>& data() const { return m_data; }
+    uint64_t sample_count() const { return m_sampleCount; }
+
+#ifndef __EMSCRIPTEN__
+    bool save(const char* path) const
+    {
+        FILE* file = fopen(path, "wb");
+        if (!file)
+            return false;
+        const bool ok = fwrite(m_data.data(), 1, m_data.size(), file) == m_data.size();
+        return fclose(file) == 0 && ok;
+    }
+#endif
+
+private:
+    std::vector<uint8_t> m_data;
+    session_recording::DeviceState m_devices[session_recording::MaxDevices];
+    double m_lastTimestamp = -1;
+    uint64_t m_sampleCount = 0;
+    size_t m_maxBytes = 0;
+    bool m_recording = false;
+    bool m_full = false;
+};
+
+// Decodes a recording back into JoystickSamples. Reads straight from memory: an in-memory blob (the only option in
+// the browser build, which has no filesystem), or natively a memory-mapped file.
+class SessionReplay
+{
+public:
+    SessionReplay() = default;
+    SessionReplay(const SessionReplay&) = delete;
+    SessionReplay& operator=(const SessionReplay&) = delete;
+
+    ~SessionReplay()
+    {
+        close();
+    }
+
+    // The data must outlive the replay.
+    bool open(const uint8_t* data, size_t size)
+    {
+        close();
+        if (size < session_recording::HeaderSize || std::memcmp(data, "JSR", 3) != 0 ||
+            data[3] != session_recording::FormatVersion)
+            return false;
+
+        m_begin = data;
+        m_end = data + size;
+        rewind();
+        return true;
+    }
+
+#ifdef JOYSTICK_SESSION_MMAP
+    bool open_file(const char* path)
+    {
+        close();
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        void* mapping = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+            mapping = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+            return false;
+
+        madvise(mapping, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+        if (!open(static_cast<const uint8_t*>(mapping), static_cast<size_t>(info.st_size)))
+        {
+            munmap(mapping, static_cast<size_t>(info.st_size));
+            return false;
+        }
+        m_mapping = mapping;
+        m_mappingSize = static_cast<size_t>(info.st_size);
+        return true;
+    }
+#endif
+
+    void close()
+    {
+#ifdef JOYSTICK_SESSION_MMAP
+        if (m_mapping)
+            munmap(m_mapping, m_mappingSize);
+#endif
+        m_mapping = NULL;
+        m_mappingSize = 0;
+        m_begin = m_end = m_cursor = NULL;
+    }
+
+    void rewind()
+    {
+        m_cursor = m_begin ? m_begin + session_recording::HeaderSize : NULL;
+        m_time = 0;
+        m_error = false;
+        for (JoystickSample& device : m_devices)
+            device = JoystickSample();
+        for (bool& known : m_known)
+            known = false;
+        // Axes are decoded as deltas against these, a second replay has to start from 0 like the recorder did.
+        std::memset(m_quantized, 0, sizeof(m_quantized));
+    }
+
+    bool is_open() const { return m_begin != NULL; }
+    bool at_end() const { return m_cursor == m_end || m_error; }
+    // Set when the recording turned out to be truncated or corrupt.
+    bool failed() const { return m_error; }
+
+    // Time of the next sample relative to the start of the recording, in seconds.
+    double next_time() const
+    {
+        uint64_t delta_us = 0;
+        const uint8_t* cursor = m_cursor;
+        if (!cursor || !session_recording::read_varint(cursor, m_end, delta_us))
+            return m_time;
+        return m_time + delta_us * 1e-6;
+    }
+
+    // Decodes the next sample. Its timestamp is `time_origin` plus the time since the start of the recording.
+    bool next(JoystickSample& sample, double time_origin = 0)
+    {
+        using namespace session_recording;
+        if (at_end() || !m_cursor)
+            return false;
+
+        const uint8_t* cursor = m_cursor;
+        uint64_t delta_us = 0;
+        if (!read_varint(cursor, m_end, delta_us) || cursor == m_end)
+            return fail();
+
+        const uint8_t flags = *cursor++;
+        const int id = flags & 0x0F;
+        JoystickSample& device = m_devices[id];
+
+        if (flags & Flag_Counts)
+        {
+            if (m_end - cursor < 2)
+                return fail();
+            const int axes_count = cursor[0];
+            const int button_count = cursor[1];
+            device.axes_count = axes_count < JoystickSample::MaxAxes ? axes_count : static_cast<int>(JoystickSample::MaxAxes);
+            device.button_count = button_count < JoystickSample::MaxButtons ? button_count
+                                                                            : static_cast<int>(JoystickSample::MaxButtons);
+            cursor += 2;
+        }
+        else if (!m_known[id])
+        {
+            return fail();
+        }
+
+        if (flags & Flag_Axes)
+        {
+            uint64_t axis_mask = 0;
+            if (!read_varint(cursor, m_end, axis_mask))
+                return fail();
+            for (uint32_t mask = static_cast<uint32_t>(axis_mask) & 0xFFFFu; mask; mask &= mask - 1)
+            {
+                const int i = state_diff::count_trailing_zeros(mask);
+                uint64_t delta = 0;
+                if (!read_varint(cursor, m_end, delta))
+                    return fail();
+                m_quantized[id][i] = static_cast<int16_t>(m_quantized[id][i] + zigzag_decode(static_cast<uint32_t>(delta)));
+                device.axes[i] = dequantize_axis(m_quantized[id][i]);
+            }
+        }
+
+        if (flags & Flag_Buttons)
+        {
+            if (cursor == m_end)
+                return fail();
+            const uint8_t word_mask = *cursor++;
+            for (int w = 0; w < JoystickSample::ButtonWords; ++w)
+            {
+                if (!(word_mask & (1u << w)))
+                    continue;
+                uint64_t bits = 0;
+                if (!read_varint(cursor, m_end, bits))
+                    return fail();
+                device.buttons[w] ^= static_cast<uint32_t>(bits);
+            }
+        }
+
+        m_known[id] = true;
+        m_cursor = cursor;
+        m_time += delta_us * 1e-6;
+
+        sample = device;
+        sample.joystick_id = id;
+        sample.timestamp = time_origin + m_time;
+        return true;
+    }
+
+private:
+    bool fail()
+    {
+        m_error = true;
+        return false;
+    }
+
+private:
+    const uint8_t* m_begin = NULL;
+    const uint8_t* m_end = NULL;
+    const uint8_t* m_cursor = NULL;
+    void* m_mapping = NULL;
+    size_t m_mappingSize = 0;
+
+    double m_time = 0;
+    bool m_error = false;
+    JoystickSample m_devices[session_recording::MaxDevices];
+    int16_t m_quantized[session_recording::MaxDevices][JoystickSample::MaxAxes] = {};
+    bool m_known[session_recording::MaxDevices] = {};
+};
+
+// Plays a SessionReplay back in real time (or scaled by `speed`), in the shape of an InputSampler::PollFunction, so
+// replayed samples go through exactly the same path as live input.
+class RealtimeReplay
+{
+public:
+    explicit RealtimeReplay(SessionReplay& replay, double speed = 1.0)
+        : m_replay(replay), m_speed(speed)
+    {
+    }
+
+    void start(double now)
+    {
+        m_replay.rewind();
+        m_start = now;
+    }
+
+    bool finished() const { return m_replay.at_end(); }
+
+    // Returns the samples due at `now`, at most `max_samples` of them.
+    int poll(double now, JoystickSample* samples, int max_samples)
+    {
+        const double position = (now - m_start) * m_speed;
+        int count = 0;
+        while (count < max_samples && !m_replay.at_end() && m_replay.next_time() <= position)
+        {
+            if (!m_replay.next(samples[count], m_start))
+                break;
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    SessionReplay& m_replay;
+    double m_speed;
+    double m_start = 0;
+};
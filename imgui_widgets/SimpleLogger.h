@@ -1,15 +1,20 @@
 #pragma once
 
 #include "imgui.h"
+#include "imgui_internal.h"
+#include "FilteredIndex.h"
+#include "LogRingBuffer.h"
 
 struct ExampleAppLog
 {
-    ImGuiTextBuffer     Buf;
+    LogRingBuffer       Lines;       // Bounded line storage, the oldest lines are dropped once a limit is reached.
     ImGuiTextFilter     Filter;
-    ImVector<int>       LineOffsets; // Index to lines offset. We maintain this with AddLog() calls.
+    FilteredIndex       FilteredLines; // Line numbers passing Filter. Rebuilt when the filter changes, extended by AddLog().
     bool                AutoScroll;  // Keep scrolling if already at the bottom.
 
-    ExampleAppLog()
+    explicit ExampleAppLog(int max_lines = 8192, int max_bytes = 256 * 1024)
+        : Lines(max_lines, max_bytes),
+          FilteredLines(max_lines)
     {
         AutoScroll = true;
         Clear();
@@ -17,21 +22,34 @@ struct ExampleAppLog
 
     void    Clear()
     {
-        Buf.clear();
-        LineOffsets.clear();
-        LineOffsets.push_back(0);
+        Lines.clear();
+        FilteredLines.reset(Lines.first_line_number());
+    }
+
+    void    SetLimits(int max_lines, int max_bytes)
+    {
+        Lines.set_limits(max_lines, max_bytes);
+        FilteredLines.set_capacity(max_lines);
+        FilteredLines.reset(Lines.first_line_number());
     }
 
     void    AddLog(const char* fmt, ...) IM_FMTARGS(2)
     {
-        int old_size = Buf.size();
+        char buf[1024];
         va_list args;
         va_start(args, fmt);
-        Buf.appendfv(fmt, args);
+        const int len = ImFormatStringV(buf, IM_ARRAYSIZE(buf), fmt, args);
         va_end(args);
-        for (int new_size = Buf.size(); old_size < new_size; old_size++)
-            if (Buf[old_size] == '\n')
-                LineOffsets.push_back(old_size + 1);
+
+        const uint64_t first_new_line = Lines.first_line_number() + Lines.size();
+        Lines.append(buf, buf + len);
+
+        if (Filter.IsActive())
+        {
+            FilteredLines.drop_before(Lines.first_line_number());
+            for (uint64_t line = first_new_line; line < EndLineNumber(); ++line)
+                FilteredLines.append(line, LinePassesFilter());
+        }
     }
 
     void    Draw(const char* title, bool* p_open = NULL)
@@ -57,7 +75,20 @@ struct ExampleAppLog
         ImGui::SameLine();
         bool copy = ImGui::Button("Copy");
         ImGui::SameLine();
-        Filter.Draw("Filter", -100.0f);
+        if (Filter.Draw("Filter", -100.0f))
+            FilteredLines.reset(Lines.first_line_number());
+
+        if (Lines.dropped_lines() > 0)
+            ImGui::TextDisabled("%d lines, %llu older lines dropped (%llu bytes)", Lines.size(),
+                                (unsigned long long)Lines.dropped_lines(), (unsigned long long)Lines.dropped_bytes());
+
+        if (Filter.IsActive())
+        {
+            // Bring the filtered index up to date, large rescans are time-sliced over several frames.
+            FilteredLines.drop_before(Lines.first_line_number());
+            if (!FilteredLines.scan(EndLineNumber(), LinePassesFilter()))
+                ImGui::ProgressBar(FilteredLines.progress(EndLineNumber()), ImVec2(-1.0f, 0.0f), "Filtering...");
+        }
 
         ImGui::Separator();
         ImGui::BeginChild("scrolling", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
@@ -68,21 +99,22 @@ struct ExampleAppLog
             ImGui::LogToClipboard();
 
         ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, 0));
-        const char* buf = Buf.begin();
-        const char* buf_end = Buf.end();
         if (Filter.IsActive())
         {
-            // In this example we don't use the clipper when Filter is enabled.
-            // This is because we don't have a random access on the result on our filter.
-            // A real application processing logs with ten of thousands of entries may want to store the result of
-            // search/filter.. especially if the filtering function is not trivial (e.g. reg-exp).
-            for (int line_no = 0; line_no < LineOffsets.Size; line_no++)
+            // Matching lines are indexed incrementally (see FilteredIndex), which gives us random access on the result
+            // of the filter, so the clipper can be used here as well. A filter change rescans the whole log, spread
+            // over as many frames as needed (see above).
+            ImGuiListClipper clipper;
+            clipper.Begin(FilteredLines.size());
+            while (clipper.Step())
             {
-                const char* line_start = buf + LineOffsets[line_no];
-                const char* line_end = (line_no + 1 < LineOffsets.Size) ? (buf + LineOffsets[line_no + 1] - 1) : buf_end;
-                if (Filter.PassFilter(line_start, line_end))
-                    ImGui::TextUnformatted(line_start, line_end);
+                for (int match_no = clipper.DisplayStart; match_no < clipper.DisplayEnd; match_no++)
+                {
+                    const int line_no = static_cast<int>(FilteredLines[match_no] - Lines.first_line_number());
+                    ImGui::TextUnformatted(Lines.line_begin(line_no), Lines.line_end(line_no));
+                }
             }
+            clipper.End();
         }
         else
         {
@@ -95,18 +127,15 @@ struct ExampleAppLog
             // on your side is recommended. Using ImGuiListClipper requires
             // - A) random access into your data
             // - B) items all being the  same height,
-            // both of which we can handle since we an array pointing to the beginning of each line of text.
-            // When using the filter (in the block of code above) we don't have random access into the data to display
-            // anymore, which is why we don't use the clipper. Storing or skimming through the search result would make
-            // it possible (and would be recommended if you want to search through tens of thousands of entries).
+            // both of which we can handle since LogRingBuffer keeps a descriptor for the beginning of each line of text.
             ImGuiListClipper clipper;
-            clipper.Begin(LineOffsets.Size);
+            clipper.Begin(Lines.size());
             while (clipper.Step())
             {
                 for (int line_no = clipper.DisplayStart; line_no < clipper.DisplayEnd; line_no++)
                 {
-                    const char* line_start = buf + LineOffsets[line_no];
-                    const char* line_end = (line_no + 1 < LineOffsets.Size) ? (buf + LineOffsets[line_no + 1] - 1) : buf_end;
+                    const char* line_start = Lines.line_begin(line_no);
+                    const char* line_end = Lines.line_end(line_no);
                     ImGui::TextUnformatted(line_start, line_end);
                 }
             }
@@ -120,4 +149,26 @@ struct ExampleAppLog
         ImGui::EndChild();
         ImGui::End();
     }
+
+private:
+    uint64_t EndLineNumber() const
+    {
+        return Lines.first_line_number() + Lines.size();
+    }
+
+    struct LineFilter
+    {
+        const ExampleAppLog* Log;
+
+        bool operator()(uint64_t line) const
+        {
+            const int line_no = static_cast<int>(line - Log->Lines.first_line_number());
+            return Log->Filter.PassFilter(Log->Lines.line_begin(line_no), Log->Lines.line_end(line_no));
+        }
+    };
+
+    LineFilter LinePassesFilter() const
+    {
+        return LineFilter{ this };
+    }
 };
\ No newline at end of file
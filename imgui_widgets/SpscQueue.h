@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Wait-free single-producer/single-consumer ring buffer. One thread may push, one (other) thread may pop, neither
+// ever blocks: push fails when the queue is full and pop fails when it is empty.
+// Capacity is rounded up to a power of two, storage is allocated once in the constructor.
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity = 4096)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size *= 2;
+        m_items.resize(size);
+        m_mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side.
+    bool try_push(const T& item)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead > m_mask)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead > m_mask)
+                return false;
+        }
+
+        m_items[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side.
+    bool try_pop(T& item)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail)
+                return false;
+        }
+
+        item = m_items[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called concurrently with push/pop.
+    size_t size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    // Producer and consumer state are padded onto separate cache lines to avoid false sharing. Padding rather than
+    // alignas, so the queue can be heap allocated without C++17 aligned new.
+    enum { CacheLine = 64 };
+
+    std::vector<T> m_items;
+    size_t m_mask = 0;
+    char m_pad0[CacheLine];
+
+    std::atomic<size_t> m_head{0}; // Next slot to pop, written by the consumer.
+    size_t m_cachedTail = 0;       // Consumer's copy of m_tail.
+    char m_pad1[CacheLine];
+
+    std::atomic<size_t> m_tail{0}; // Next slot to push, written by the producer.
+    size_t m_cachedHead = 0;       // Producer's copy of m_head.
+    char m_pad2[CacheLine];
+};
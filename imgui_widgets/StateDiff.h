@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define JOYSTICK_SIMD_WASM 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JOYSTICK_SIMD_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define JOYSTICK_SIMD_NEON 1
+#endif
+
+// Change detection kernels for JoystickState. Axes are processed four at a time and buttons sixteen at a time with
+// wasm SIMD128, SSE2 or NEON (AArch64), whichever the target has, with a scalar fallback.
+// Axis arrays and button words are processed in groups of 4 and must be padded accordingly. Loads are unaligned, but
+// keeping the arrays 16-byte aligned avoids split loads.
+namespace state_diff
+{
+
+inline int count_trailing_zeros(uint32_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(value);
+#else
+    int count = 0;
+    while (!(value & 1u))
+    {
+        value >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+// Packs `count` bytes (non-zero = pressed) into bits, `words` must have room for (count + 31) / 32 words.
+inline void pack_buttons(const uint8_t* buttons, int count, uint32_t* words)
+{
+    for (int w = 0; w < (count + 31) / 32; ++w)
+        words[w] = 0;
+
+    int i = 0;
+#if defined(JOYSTICK_SIMD_WASM) || defined(JOYSTICK_SIMD_SSE2)
+    for (; i + 16 <= count; i += 16)
+    {
+#if defined(JOYSTICK_SIMD_WASM)
+        const v128_t bytes = wasm_v128_load(buttons + i);
+        const uint32_t bits = wasm_i8x16_bitmask(wasm_i8x16_ne(bytes, wasm_i8x16_splat(0)));
+#else
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buttons + i));
+        const uint32_t bits = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()))) &
+                              0xFFFFu;
+#endif
+        words[i / 32] |= bits << (i % 32);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        if (buttons[i])
+            words[i / 32] |= 1u << (i % 32);
+    }
+}
+
+// changed = a ^ b over `word_count` words (a multiple of 4).
+inline void diff_buttons(const uint32_t* a, const uint32_t* b, uint32_t* changed, int word_count)
+{
+    for (int w = 0; w < word_count; w += 4)
+    {
+#if defined(JOYSTICK_SIMD_WASM)
+        wasm_v128_store(changed + w, wasm_v128_xor(wasm_v128_load(a + w), wasm_v128_load(b + w)));
+#elif defined(JOYSTICK_SIMD_SSE2)
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + w));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + w));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(changed + w), _mm_xor_si128(va, vb));
+#elif defined(JOYSTICK_SIMD_NEON)
+        vst1q_u32(changed + w, veorq_u32(vld1q_u32(a + w), vld1q_u32(b + w)));
+#else
+        for (int k = 0; k < 4; ++k)
+            changed[w + k] = a[w + k] ^ b[w + k];
+#endif
+    }
+}
+
+// Snaps every value within its deadzone to 0, in place. `count` is a multiple of 4.
+inline void apply_deadzone(float* values, const float* deadzone, int count)
+{
+    for (int i = 0; i < count; i += 4)
+    {
+#if defined(JOYSTICK_SIMD_WASM)
+        const v128_t v = wasm_v128_load(values + i);
+        const v128_t outside = wasm_f32x4_ge(wasm_f32x4_abs(v), wasm_v128_load(deadzone + i));
+        wasm_v128_store(values + i, wasm_v128_and(v, outside));
+#elif defined(JOYSTICK_SIMD_SSE2)
+        const __m128 v = _mm_loadu_ps(values + i);
+        const __m128 abs = _mm_andnot_ps(_mm_set1_ps(-0.f), v);
+        const __m128 outside = _mm_cmpge_ps(abs, _mm_loadu_ps(deadzone + i));
+        _mm_storeu_ps(values + i, _mm_and_ps(v, outside));
+#elif defined(JOYSTICK_SIMD_NEON)
+        const float32x4_t v = vld1q_f32(values + i);
+        const uint32x4_t outside = vcgeq_f32(vabsq_f32(v), vld1q_f32(deadzone + i));
+        vst1q_f32(values + i, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), outside)));
+#else
+        for (int k = 0; k < 4; ++k)
+        {
+            const float v = values[i + k];
+            values[i + k] = (v < 0 ? -v : v) >= deadzone[i + k] ? v : 0.f;
+        }
+#endif
+    }
+}
+
+// Bit i is set when |values[i] - reference[i]| > threshold[i]. `count` is a multiple of 4, at most 32.
+inline uint32_t diff_axes(const float* values, const float* reference, const float* threshold, int count)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < count; i += 4)
+    {
+#if defined(JOYSTICK_SIMD_WASM)
+        const v128_t delta = wasm_f32x4_abs(wasm_f32x4_sub(wasm_v128_load(values + i), wasm_v128_load(reference + i)));
+        const uint32_t bits = wasm_i32x4_bitmask(wasm_f32x4_gt(delta, wasm_v128_load(threshold + i)));
+#elif defined(JOYSTICK_SIMD_SSE2)
+        const __m128 difference = _mm_sub_ps(_mm_loadu_ps(values + i), _mm_loadu_ps(reference + i));
+        const __m128 delta = _mm_andnot_ps(_mm_set1_ps(-0.f), difference);
+        const uint32_t bits = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmpgt_ps(delta, _mm_loadu_ps(threshold + i))));
+#elif defined(JOYSTICK_SIMD_NEON)
+        const float32x4_t delta = vabdq_f32(vld1q_f32(values + i), vld1q_f32(reference + i));
+        const uint32x4_t gt = vcgtq_f32(delta, vld1q_f32(threshold + i));
+        const uint32x4_t weights = { 1, 2, 4, 8 };
+        const uint32_t bits = vaddvq_u32(vandq_u32(gt, weights));
+#else
+        uint32_t bits = 0;
+        for (int k = 0; k < 4; ++k)
+        {
+            const float delta = values[i + k] - reference[i + k];
+            if ((delta < 0 ? -delta : delta) > threshold[i + k])
+                bits |= 1u << k;
+        }
+#endif
+        mask |= bits << i;
+    }
+    return mask;
+}
+
+} // namespace state_diff
@@ -0,0 +1,284 @@
+#pragma once
+
+#include "Clock.h"
+#include "JoystickEventLog.h"
+#include "JoystickSample.h"
+#include "SpscQueue.h"
+#include "TelemetryPacket.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+#include <chrono>
+#include <thread>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define JOYSTICK_TELEMETRY 1
+#endif
+
+#ifdef JOYSTICK_TELEMETRY
+
+// Streams samples and change events to a local socket for external tools, in the packet format of TelemetryPacket.h.
+//
+// The caller (the render loop) only pushes records into a wait-free bounded queue, which never blocks: when the queue
+// is full the record is dropped and counted. A sender thread batches queued records into datagrams and sends them
+// without blocking either, a slow or missing receiver loses packets and sees the gaps in the sequence numbers.
+// A partially filled packet goes out after flush_interval seconds.
+//
+// Destinations are "udp:host:port" or "unix:path" (a datagram socket, bound by the receiver first).
+class TelemetryExporter
+{
+public:
+    explicit TelemetryExporter(size_t queue_capacity = 8192, double flush_interval = 0.005)
+        : m_queue(queue_capacity), m_flushInterval(flush_interval)
+    {
+    }
+
+    ~TelemetryExporter()
+    {
+        stop();
+    }
+
+    TelemetryExporter(const TelemetryExporter&) = delete;
+    TelemetryExporter& operator=(const TelemetryExporter&) = delete;
+
+    bool start(const char* destination)
+    {
+        stop();
+        m_socket = open_socket(destination);
+        if (m_socket < 0)
+            return false;
+
+        m_running = true;
+        m_thread = std::thread(&TelemetryExporter::run, this);
+        return true;
+    }
+
+    // Sends whatever is still queued, then closes the socket.
+    void stop()
+    {
+        if (m_running)
+        {
+            m_running = false;
+            m_thread.join();
+        }
+        if (m_socket >= 0)
+        {
+            ::close(m_socket);
+            m_socket = -1;
+        }
+    }
+
+    bool is_running() const { return m_running; }
+
+    // Producer side, one thread only. Return false when the record was dropped.
+    bool export_sample(const JoystickSample& sample)
+    {
+        Entry entry;
+        entry.type = telemetry::RecordType_Sample;
+        entry.sample = sample;
+        return push(entry);
+    }
+
+    bool export_event(const JoystickEvent& event)
+    {
+        Entry entry;
+        entry.type = telemetry::RecordType_Event;
+        entry.event = event;
+        return push(entry);
+    }
+
+    // One event per axis and button reported as changed for `sample`, e.g. by JoystickWidget::changed_axes() and
+    // changed_buttons().
+    void export_changes(const JoystickSample& sample, uint32_t changed_axes, const uint32_t* changed_buttons)
+    {
+        JoystickEvent event{};
+        event.timestamp = sample.timestamp;
+        event.device = static_cast<uint8_t>(sample.joystick_id);
+
+        event.kind = JoystickEventKind_Axis;
+        for (uint32_t mask = changed_axes; mask; mask &= mask - 1)
+        {
+            event.index = static_cast<uint16_t>(state_diff::count_trailing_zeros(mask));
+            event.value = sample.axes[event.index];
+            export_event(event);
+        }
+
+        event.kind = JoystickEventKind_Button;
+        for (int w = 0; w < JoystickSample::ButtonWords; ++w)
+        {
+            for (uint32_t mask = changed_buttons[w]; mask; mask &= mask - 1)
+            {
+                event.index = static_cast<uint16_t>(w * 32 + state_diff::count_trailing_zeros(mask));
+                event.value = sample.button(event.index) ? 1.f : 0.f;
+                export_event(event);
+            }
+        }
+    }
+
+    // Records lost because the queue was full.
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint64_t records_sent() const { return m_recordsSent.load(std::memory_order_relaxed); }
+    uint64_t packets_sent() const { return m_packetsSent.load(std::memory_order_relaxed); }
+    uint64_t bytes_sent() const { return m_bytesSent.load(std::memory_order_relaxed); }
+    // Packets the socket didn't take (no receiver, receiver buffer full).
+    uint64_t send_errors() const { return m_sendErrors.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry
+    {
+        int type = 0;
+        JoystickSample sample;
+        JoystickEvent event{};
+    };
+
+    bool push(const Entry& entry)
+    {
+        if (m_queue.try_push(entry))
+            return true;
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    static int open_socket(const char* destination)
+    {
+        if (std::strncmp(destination, "unix:", 5) == 0)
+        {
+            sockaddr_un address;
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            if (std::strlen(destination + 5) >= sizeof(address.sun_path))
+                return -1;
+            std::strcpy(address.sun_path, destination + 5);
+
+            const int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+            if (fd >= 0 && connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+            {
+                ::close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+        if (std::strncmp(destination, "udp:", 4) == 0)
+        {
+            char host[256];
+            const char* port = std::strrchr(destination + 4, ':');
+            if (!port || port - (destination + 4) >= static_cast<int>(sizeof(host)))
+                return -1;
+            std::memcpy(host, destination + 4, port - (destination + 4));
+            host[port - (destination + 4)] = '\0';
+
+            addrinfo hints;
+            std::memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_DGRAM;
+            addrinfo* addresses = NULL;
+            if (getaddrinfo(host, port + 1, &hints, &addresses) != 0)
+                return -1;
+
+            int fd = -1;
+            for (addrinfo* address = addresses; address && fd < 0; address = address->ai_next)
+            {
+                fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+                if (fd >= 0 && connect(fd, address->ai_addr, address->ai_addrlen) != 0)
+                {
+                    ::close(fd);
+                    fd = -1;
+                }
+            }
+            freeaddrinfo(addresses);
+            return fd;
+        }
+
+        return -1;
+    }
+
+    void send_packet()
+    {
+        const uint8_t* data = m_packet.finish();
+        if (send(m_socket, data, m_packet.size(), MSG_DONTWAIT) == static_cast<ssize_t>(m_packet.size()))
+        {
+            m_packetsSent.fetch_add(1, std::memory_order_relaxed);
+            m_recordsSent.fetch_add(m_packet.record_count(), std::memory_order_relaxed);
+            m_bytesSent.fetch_add(m_packet.size(), std::memory_order_relaxed);
+        }
+        else
+        {
+            m_sendErrors.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Lost packets still use up their sequence number, that's how the receiver notices.
+        ++m_sequence;
+    }
+
+    template<typename Record>
+    void add(const Record& record, double timestamp)
+    {
+        if (!m_packet.empty())
+        {
+            if (m_packet.add(record))
+                return;
+            send_packet();
+        }
+        m_packet.begin(m_sequence, timestamp);
+        m_packetStart = now_seconds();
+        m_packet.add(record);
+    }
+
+    void run()
+    {
+        Entry entry;
+        m_packet.begin(m_sequence, 0);
+        for (;;)
+        {
+            // Acquire: everything pushed before stop() is visible once it is seen.
+            const bool running = m_running.load(std::memory_order_acquire);
+
+            bool popped = false;
+            while (m_queue.try_pop(entry))
+            {
+                popped = true;
+                if (entry.type == telemetry::RecordType_Sample)
+                    add(entry.sample, entry.sample.timestamp);
+                else
+                    add(entry.event, entry.event.timestamp);
+            }
+
+            if (!m_packet.empty() && (!running || now_seconds() - m_packetStart >= m_flushInterval))
+            {
+                send_packet();
+                m_packet.begin(m_sequence, 0);
+            }
+
+            if (!running)
+                break;
+            if (!popped)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+private:
+    SpscQueue<Entry> m_queue;
+    double m_flushInterval;
+    int m_socket = -1;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+
+    // Sender thread only.
+    telemetry::PacketWriter m_packet;
+    uint32_t m_sequence = 0;
+    double m_packetStart = 0;
+
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_recordsSent{0};
+    std::atomic<uint64_t> m_packetsSent{0};
+    std::atomic<uint64_t> m_bytesSent{0};
+    std::atomic<uint64_t> m_sendErrors{0};
+};
+
+#endif // JOYSTICK_TELEMETRY
@@ -0,0 +1,263 @@
+#pragma once
+
+#include "JoystickEventLog.h"
+#include "JoystickSample.h"
+#include "SessionRecording.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Datagram format of the telemetry stream, see TelemetryExporter.
+//
+// Every packet is self-contained, so a lost packet only loses its own records. All integers are little-endian.
+//   header   "JT", byte format version, byte reserved, uint32 sequence number, float64 base time (seconds),
+//            uint16 record count, uint16 reserved
+//   records  byte record type, byte device id, zigzag varint time relative to the base time in microseconds, then
+//     sample: byte axes count, byte button count, int16 per axis (quantized like SessionRecording), uint32 per
+//             started 32-bit button word
+//     event:  byte kind (JoystickEventKind), varint axis/button index, int16 quantized value
+// Sequence numbers increase by one per packet sent (or lost on the way), receivers count the gaps.
+namespace telemetry
+{
+
+enum
+{
+    FormatVersion = 1,
+    HeaderSize = 20,
+    MaxPacketSize = 1400, // Stays below a typical Ethernet MTU, also when sent over a real network.
+    RecordType_Sample = 1,
+    RecordType_Event = 2,
+};
+
+struct Record
+{
+    int type = 0;
+    JoystickSample sample;
+    JoystickEvent event{};
+};
+
+// Builds one packet in a fixed buffer, never allocates.
+class PacketWriter
+{
+public:
+    void begin(uint32_t sequence, double base_time)
+    {
+        m_sequence = sequence;
+        m_baseTime = base_time;
+        m_recordCount = 0;
+        m_size = HeaderSize;
+    }
+
+    // Both return false, without adding anything, when the record doesn't fit anymore.
+    bool add(const JoystickSample& sample)
+    {
+        const int button_words = (sample.button_count + 31) / 32;
+        if (!reserve(1 + 1 + 10 + 2 + 2 * sample.axes_count + 4 * button_words))
+            return false;
+
+        begin_record(RecordType_Sample, sample.joystick_id, sample.timestamp);
+        m_data[m_size++] = static_cast<uint8_t>(sample.axes_count);
+        m_data[m_size++] = static_cast<uint8_t>(sample.button_count);
+        for (int i = 0; i < sample.axes_count; ++i)
+            write_u16(static_cast<uint16_t>(session_recording::quantize_axis(sample.axes[i])));
+        for (int i = 0; i < button_words; ++i)
+            write_u32(sample.buttons[i]);
+        return true;
+    }
+
+    bool add(const JoystickEvent& event)
+    {
+        if (!reserve(1 + 1 + 10 + 1 + 3 + 2))
+            return false;
+
+        begin_record(RecordType_Event, event.device, event.timestamp);
+        m_data[m_size++] = event.kind;
+        write_varint(event.index);
+        write_u16(static_cast<uint16_t>(session_recording::quantize_axis(event.value)));
+        return true;
+    }
+
+    // Fills in the header, the packet is data()[0, size()).
+    const uint8_t* finish()
+    {
+        m_data[0] = 'J';
+        m_data[1] = 'T';
+        m_data[2] = FormatVersion;
+        m_data[3] = 0;
+        uint64_t base_time_bits = 0;
+        std::memcpy(&base_time_bits, &m_baseTime, sizeof(base_time_bits));
+        for (int i = 0; i < 4; ++i)
+            m_data[4 + i] = static_cast<uint8_t>(m_sequence >> (8 * i));
+        for (int i = 0; i < 8; ++i)
+            m_data[8 + i] = static_cast<uint8_t>(base_time_bits >> (8 * i));
+        m_data[16] = static_cast<uint8_t>(m_recordCount);
+        m_data[17] = static_cast<uint8_t>(m_recordCount >> 8);
+        m_data[18] = 0;
+        m_data[19] = 0;
+        return m_data;
+    }
+
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    int record_count() const { return m_recordCount; }
+    bool empty() const { return m_recordCount == 0; }
+
+private:
+    bool reserve(size_t worst_case)
+    {
+        return m_recordCount < 0xFFFF && m_size + worst_case <= MaxPacketSize;
+    }
+
+    void begin_record(int type, int device, double timestamp)
+    {
+        ++m_recordCount;
+        m_data[m_size++] = static_cast<uint8_t>(type);
+        m_data[m_size++] = static_cast<uint8_t>(device);
+
+        // Records of one packet are at most a flush interval apart, clamped to what fits anyway.
+        double delta_us = (timestamp - m_baseTime) * 1e6;
+        delta_us = delta_us < -2e9 ? -2e9 : (delta_us > 2e9 ? 2e9 : delta_us);
+        write_varint(session_recording::zigzag_encode(static_cast<int32_t>(std::lrint(delta_us))));
+    }
+
+    void write_varint(uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            m_data[m_size++] = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        m_data[m_size++] = static_cast<uint8_t>(value);
+    }
+
+    void write_u16(uint16_t value)
+    {
+        m_data[m_size++] = static_cast<uint8_t>(value);
+        m_data[m_size++] = static_cast<uint8_t>(value >> 8);
+    }
+
+    void write_u32(uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            m_data[m_size++] = static_cast<uint8_t>(value >> (8 * i));
+    }
+
+private:
+    uint8_t m_data[MaxPacketSize];
+    size_t m_size = HeaderSize;
+    int m_recordCount = 0;
+    uint32_t m_sequence = 0;
+    double m_baseTime = 0;
+};
+
+// Decodes one packet. Stops at the first malformed record, failed() tells truncated packets from complete ones.
+class PacketReader
+{
+public:
+    bool open(const uint8_t* data, size_t size)
+    {
+        m_cursor = m_end = NULL;
+        m_error = false;
+        if (size < HeaderSize || data[0] != 'J' || data[1] != 'T' || data[2] != FormatVersion)
+            return false;
+
+        uint64_t base_time_bits = 0;
+        m_sequence = 0;
+        for (int i = 0; i < 4; ++i)
+            m_sequence |= static_cast<uint32_t>(data[4 + i]) << (8 * i);
+        for (int i = 0; i < 8; ++i)
+            base_time_bits |= static_cast<uint64_t>(data[8 + i]) << (8 * i);
+        std::memcpy(&m_baseTime, &base_time_bits, sizeof(m_baseTime));
+        m_recordCount = data[16] | (data[17] << 8);
+
+        m_cursor = data + HeaderSize;
+        m_end = data + size;
+        m_remaining = m_recordCount;
+        return true;
+    }
+
+    uint32_t sequence() const { return m_sequence; }
+    double base_time() const { return m_baseTime; }
+    int record_count() const { return m_recordCount; }
+    bool failed() const { return m_error; }
+
+    bool next(Record& record)
+    {
+        if (m_remaining == 0 || m_error)
+            return false;
+
+        uint64_t time = 0;
+        if (m_end - m_cursor < 2)
+            return fail();
+        record.type = m_cursor[0];
+        const int device = m_cursor[1];
+        m_cursor += 2;
+        if (!session_recording::read_varint(m_cursor, m_end, time))
+            return fail();
+        const double timestamp = m_baseTime + session_recording::zigzag_decode(static_cast<uint32_t>(time)) * 1e-6;
+
+        if (record.type == RecordType_Sample)
+        {
+            if (m_end - m_cursor < 2)
+                return fail();
+            JoystickSample& sample = record.sample;
+            sample = JoystickSample();
+            sample.joystick_id = device;
+            sample.timestamp = timestamp;
+            sample.axes_count = m_cursor[0];
+            sample.button_count = m_cursor[1];
+            m_cursor += 2;
+
+            const int button_words = (sample.button_count + 31) / 32;
+            if (sample.axes_count > JoystickSample::MaxAxes || sample.button_count > JoystickSample::MaxButtons ||
+                m_end - m_cursor < 2 * sample.axes_count + 4 * button_words)
+                return fail();
+            for (int i = 0; i < sample.axes_count; ++i, m_cursor += 2)
+                sample.axes[i] = session_recording::dequantize_axis(static_cast<int16_t>(m_cursor[0] | (m_cursor[1] << 8)));
+            for (int i = 0; i < button_words; ++i, m_cursor += 4)
+                sample.buttons[i] = m_cursor[0] | (m_cursor[1] << 8) | (m_cursor[2] << 16) |
+                                    (static_cast<uint32_t>(m_cursor[3]) << 24);
+        }
+        else if (record.type == RecordType_Event)
+        {
+            uint64_t index = 0;
+            if (m_end - m_cursor < 1)
+                return fail();
+            JoystickEvent& event = record.event;
+            event.timestamp = timestamp;
+            event.device = static_cast<uint8_t>(device);
+            event.kind = *m_cursor++;
+            if (!session_recording::read_varint(m_cursor, m_end, index) || m_end - m_cursor < 2)
+                return fail();
+            event.index = static_cast<uint16_t>(index);
+            event.value = session_recording::dequantize_axis(static_cast<int16_t>(m_cursor[0] | (m_cursor[1] << 8)));
+            m_cursor += 2;
+        }
+        else
+        {
+            return fail();
+        }
+
+        --m_remaining;
+        return true;
+    }
+
+private:
+    bool fail()
+    {
+        m_error = true;
+        return false;
+    }
+
+private:
+    const uint8_t* m_cursor = NULL;
+    const uint8_t* m_end = NULL;
+    uint32_t m_sequence = 0;
+    double m_baseTime = 0;
+    int m_recordCount = 0;
+    int m_remaining = 0;
+    bool m_error = false;
+};
+
+} // namespace telemetry
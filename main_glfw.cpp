@@ -13,62 +13,20 @@
 #include "implot.h"
 #include <stdio.h>
 #include <emscripten.h>
-#include <SDL.h>
 #include <GLFW/glfw3.h>
-#include "JoystickWidget.h"
-
-#include <array>
+// Counts heap allocations, see FrameAllocations. The counting operator new is defined in this file.
+#define ALLOCATION_COUNTER_IMPLEMENTATION
+#include "AllocationCounter.h"
+#include "BakedFontAtlas.h"
+#include "GlfwInputSource.h"
+#include "JoystickApp.h"
 
 GLFWwindow* window;
 
-JoystickWidget joystickWidget0;
-
-std::vector<int> find_available_joysticks()
-{
-    std::vector<int> joysticks;
-    joysticks.reserve(GLFW_JOYSTICK_16 + 1);
-    for(int i = GLFW_JOYSTICK_1; i < GLFW_JOYSTICK_16; ++i)
-    {
-        if (glfwJoystickPresent(i))
-            joysticks.push_back(i);
-    }
-    return joysticks;
-}
-
-bool update_joystick(int glfw_joystick_id, JoystickWidget& jw)
-{
-    if (!glfwJoystickPresent(glfw_joystick_id))
-        return false;
-
-    const char* name = glfwGetJoystickName(glfw_joystick_id);
-
-    int axes_count = 0;
-    const float *axes = glfwGetJoystickAxes(glfw_joystick_id, &axes_count);
-
-    int button_count = 0;
-    const unsigned char *buttons = glfwGetJoystickButtons(glfw_joystick_id, &button_count);
-
-    jw.update(axes_count, axes, button_count, buttons, name, glfw_joystick_id);
-
-    return true;
-}
-
-void draw_demo_windows()
-{
-    static bool show_demo_window = false;
-    static bool show_plot_demo_window = false;
-
-    ImGui::Begin("Demo windows");
-    ImGui::Checkbox("Show ImGui demo window", &show_demo_window);
-    ImGui::Checkbox("Show ImPlot demo window", &show_plot_demo_window);
-    ImGui::End();
-
-    if (show_demo_window)
-        ImGui::ShowDemoWindow(&show_demo_window);
-
-    if (show_plot_demo_window)
-        ImPlot::ShowDemoWindow(&show_plot_demo_window);
-}
+// Joysticks are polled at this rate independently of the frame rate, see InputSampler.
+const double inputSampleRate = 1000.0;
+GlfwInputSource input(inputSampleRate);
+JoystickApp app(input);
 
 static void main_loop()
 {
@@ -81,29 +39,53 @@ static void main_loop()
     // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
     // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
     // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-    glfwPollEvents();
+    FrameProfiler& profiler = app.profiler();
+    profiler.begin_frame(now_seconds());
+    {
+        ScopedFrameTimer timer(profiler, FrameMetric_PollEvents);
+        glfwPollEvents();
+    }
 
-    // Start the Dear ImGui frame
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
+    if (app.update())
+        app.throttle().notify_activity();
 
-    draw_demo_windows();
+    // Idle: keep the last presented frame. Only rendered frames are profiled, inputs taken meanwhile are aged by the
+    // next one.
+    if (!app.throttle().should_render(now_seconds()))
+        return;
 
-    auto availableJoysticks = find_available_joysticks();
-    if (update_joystick(availableJoysticks.front(), joystickWidget0))
-        joystickWidget0.draw();
+    {
+        // Build: starting the frame and building all windows, timed here only.
+        ScopedFrameTimer timer(profiler, FrameMetric_Build);
+
+        // Start the Dear ImGui frame
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+        app.draw();
+    }
 
     // Rendering
-    ImGui::Render();
-    int display_w, display_h;
-    glfwGetFramebufferSize(window, &display_w, &display_h);
-    glViewport(0, 0, display_w, display_h);
-    glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
-    glClear(GL_COLOR_BUFFER_BIT);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-    glfwSwapBuffers(window);
+    {
+        ScopedFrameTimer timer(profiler, FrameMetric_Render);
+        ImGui::Render();
+    }
+
+    {
+        ScopedFrameTimer timer(profiler, FrameMetric_RenderDrawData);
+        int display_w, display_h;
+        glfwGetFramebufferSize(window, &display_w, &display_h);
+        glViewport(0, 0, display_w, display_h);
+        glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
+        glClear(GL_COLOR_BUFFER_BIT);
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+        glfwSwapBuffers(window);
+    }
+    app.startup().frame_presented();
+    app.allocations().end_frame();
+    profiler.end_frame(now_seconds());
 }
 
 static void glfw_error_callback(int error, const char* description)
@@ -111,8 +93,19 @@ static void glfw_error_callback(int error, const char* description)
     fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
 
+// Input callbacks only wake up the app's RenderThrottle. They are installed before the ImGui GLFW backend, which chains to
+// the callbacks it replaces.
+static void activity_cursor_pos_callback(GLFWwindow*, double, double) { app.throttle().notify_activity(); }
+static void activity_mouse_button_callback(GLFWwindow*, int, int, int) { app.throttle().notify_activity(); }
+static void activity_scroll_callback(GLFWwindow*, double, double) { app.throttle().notify_activity(); }
+static void activity_key_callback(GLFWwindow*, int, int, int, int) { app.throttle().notify_activity(); }
+static void activity_char_callback(GLFWwindow*, unsigned int) { app.throttle().notify_activity(); }
+static void activity_window_size_callback(GLFWwindow*, int, int) { app.throttle().notify_activity(); }
+
 int main(int, char**)
 {
+    app.startup().mark("main");
+
     // Setup window
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit())
@@ -127,11 +120,13 @@ int main(int, char**)
     window = glfwCreateWindow(1280, 720, "Dear ImGui GLFW+OpenGL3 example", NULL, NULL);
     if (window == NULL)
         return 1;
+    app.startup().mark("window");
     glfwMakeContextCurrent(window);
     glfwSwapInterval(1); // Enable vsync
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
+    allocation_counter::install_imgui_allocator();
     ImGui::CreateContext();
     ImPlot::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
@@ -146,9 +141,25 @@ int main(int, char**)
     ImGui::StyleColorsDark();
     //ImGui::StyleColorsClassic();
 
+    // Load the font atlas baked into the binary instead of rasterising the fonts (falls back to that without one).
+    // The renderer backend only uploads the texture on the first frame.
+    if (baked_font_atlas::load_or_build(io.Fonts))
+        app.startup().mark("fonts (baked)");
+    else
+        app.startup().mark("fonts (built)");
+
     // Setup Platform/Renderer backends
+    glfwSetCursorPosCallback(window, activity_cursor_pos_callback);
+    glfwSetMouseButtonCallback(window, activity_mouse_button_callback);
+    glfwSetScrollCallback(window, activity_scroll_callback);
+    glfwSetKeyCallback(window, activity_key_callback);
+    glfwSetCharCallback(window, activity_char_callback);
+    glfwSetWindowSizeCallback(window, activity_window_size_callback);
     ImGui_ImplGlfw_InitForOther(window, true);
     ImGui_ImplOpenGL3_Init(glsl_version);
+    app.startup().mark("imgui");
+
+    app.start();
 
     // This function call won't return, and will engage in an infinite loop, processing events from the browser, and dispatching them.
     emscripten_set_main_loop(main_loop, 0, 1);
@@ -15,18 +15,29 @@
 #include <emscripten.h>
 #include <SDL.h>
 #include <SDL_opengles2.h>
+// Counts heap allocations, see FrameAllocations. The counting operator new is defined in this file.
+#define ALLOCATION_COUNTER_IMPLEMENTATION
+#include "AllocationCounter.h"
+#include "BakedFontAtlas.h"
+#include "SdlInputSource.h"
+#include "JoystickApp.h"
 
 // Emscripten requires to have full control over the main loop. We're going to store our SDL book-keeping variables globally.
 // Having a single function that acts as a loop prevents us to store state in the stack of said function. So we need some location for this.
 SDL_Window*     g_Window = NULL;
 SDL_GLContext   g_GLContext = NULL;
-SDL_Joystick*   joystick = NULL;
+
+// Joystick input comes from SDL joystick events, see SdlInputSource.
+SdlInputSource input;
+JoystickApp app(input);
 
 // For clarity, our main loop code is declared at the end.
 static void main_loop();
 
 int main(int, char**)
 {
+    app.startup().mark("main");
+
     // Setup SDL
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER | SDL_INIT_JOYSTICK) != 0)
     {
@@ -58,10 +69,12 @@ int main(int, char**)
         fprintf(stderr, "Failed to initialize WebGL context!\n");
         return 1;
     }
+    app.startup().mark("window");
     SDL_GL_SetSwapInterval(1); // Enable vsync
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
+    allocation_counter::install_imgui_allocator();
     ImGui::CreateContext();
     ImPlot::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
@@ -76,9 +89,19 @@ int main(int, char**)
     ImGui::StyleColorsDark();
     //ImGui::StyleColorsClassic();
 
+    // Load the font atlas baked into the binary instead of rasterising the fonts (falls back to that without one).
+    // The renderer backend only uploads the texture on the first frame.
+    if (baked_font_atlas::load_or_build(io.Fonts))
+        app.startup().mark("fonts (baked)");
+    else
+        app.startup().mark("fonts (built)");
+
     // Setup Platform/Renderer backends
     ImGui_ImplSDL2_InitForOpenGL(g_Window, g_GLContext);
     ImGui_ImplOpenGL3_Init(glsl_version);
+    app.startup().mark("imgui");
+
+    app.start();
 
     // This function call won't return, and will engage in an infinite loop, processing events from the browser, and dispatching them.
     emscripten_set_main_loop(main_loop, 0, 1);
@@ -89,9 +112,6 @@ static void main_loop()
     ImGuiIO& io = ImGui::GetIO();
   //  IM_UNUSED(arg); // We can pass this argument as the second parameter of emscripten_set_main_loop_arg(), but we don't use that.
 
-    // Our state (make them static = more or less global) as a convenience to keep the example terse.
-    static bool show_demo_window = true;
-    static bool show_plot_demo_window = true;
     static ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
     // Poll and handle events (inputs, window resize, etc.)
@@ -99,73 +119,56 @@ static void main_loop()
     // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
     // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
     // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-
-    if (joystick == NULL)
-    {
-        joystick = SDL_JoystickOpen(0);
-
-        if (joystick == NULL)
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_JoystickOpen(%d) failed: %s\n", 0,
-                        SDL_GetError());
-    }
-
-    SDL_Event event;
-    while (SDL_PollEvent(&event))
+    FrameProfiler& profiler = app.profiler();
+    profiler.begin_frame(now_seconds());
     {
-        ImGui_ImplSDL2_ProcessEvent(&event);
-        // Capture events here, based on io.WantCaptureMouse and io.WantCaptureKeyboard
+        ScopedFrameTimer timer(profiler, FrameMetric_PollEvents);
+        SDL_Event event;
+        while (SDL_PollEvent(&event))
+        {
+            ImGui_ImplSDL2_ProcessEvent(&event);
+            // Joystick events become samples, anything else may change what ImGui shows.
+            if (!input.process_event(event))
+                app.throttle().notify_activity();
+        }
     }
 
-    // Start the Dear ImGui frame
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplSDL2_NewFrame(g_Window);
-    ImGui::NewFrame();
-
-    if (show_demo_window)
-        ImGui::ShowDemoWindow(&show_demo_window);
+    if (app.update())
+        app.throttle().notify_activity();
 
-    if (show_plot_demo_window)
-        ImPlot::ShowDemoWindow(&show_plot_demo_window);
+    // Idle: keep the last presented frame. Only rendered frames are profiled, inputs taken meanwhile are aged by the
+    // next one.
+    if (!app.throttle().should_render(now_seconds()))
+        return;
 
-    ImGui::Begin("Plot test window");
-    if (ImPlot::BeginPlot("Scatter Plot", "X", "Y"))
     {
-        ImPlot::PushStyleVar(ImPlotStyleVar_FillAlpha, 0.25f);
+        // Build: starting the frame and building all windows, timed here only.
+        ScopedFrameTimer timer(profiler, FrameMetric_Build);
 
-        if (joystick != NULL)
-        {
-            static int x = 0;
-            static int y = 0;
-
-            int xn = SDL_JoystickGetAxis(joystick, 0);
-            int yn = SDL_JoystickGetAxis(joystick, 1);
-
-            if (x != xn || y != yn)
-            {
-                x = xn;
-                y = yn;
-            }
-
-            ImPlot::SetNextMarkerStyle(ImPlotMarker_Square, 6, ImVec4(0, 1, 0, 0.5f), IMPLOT_AUTO,
-                                       ImVec4(0, 1, 0, 1));
-
-            float xf = (x + 32768) / 65535.;
-            float yf = (y + 32768) / 65535.;
-
-            ImPlot::PlotScatter("Main axis", &xf, &yf, 1);
-        }
+        // Start the Dear ImGui frame
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplSDL2_NewFrame(g_Window);
+        ImGui::NewFrame();
 
-        ImPlot::PopStyleVar();
-        ImPlot::EndPlot();
+        app.draw();
     }
-    ImGui::End();
 
     // Rendering
-    ImGui::Render();
-    SDL_GL_MakeCurrent(g_Window, g_GLContext);
-    glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
-    glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
-    glClear(GL_COLOR_BUFFER_BIT);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-    SDL_GL_SwapWindow(g_Window);
+    {
+        ScopedFrameTimer timer(profiler, FrameMetric_Render);
+        ImGui::Render();
+    }
+
+    {
+        ScopedFrameTimer timer(profiler, FrameMetric_RenderDrawData);
+        SDL_GL_MakeCurrent(g_Window, g_GLContext);
+        glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
+        glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
+        glClear(GL_COLOR_BUFFER_BIT);
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        SDL_GL_SwapWindow(g_Window);
+    }
+    app.startup().frame_presented();
+    app.allocations().end_frame();
+    profiler.end_frame(now_seconds());
 }
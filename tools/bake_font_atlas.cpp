@@ -0,0 +1,98 @@
+// Bakes the font atlas the apps would otherwise build at startup and prints it as a C++ header embedding the blob,
+// see BakedFontAtlas.h. Run by the build (cmake/BakeFontAtlas.cmake), under Emscripten through node, so the atlas
+// comes from the same Dear ImGui build the apps link.
+//
+// Usage: bake_font_atlas > BakedFontAtlasData.h
+
+#include "BakedFontAtlas.h"
+
+#include "imgui.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Whether `loaded`, read back from the blob, matches the `built` atlas it was baked from: texture, glyphs and the
+// glyph lookups the renderer does.
+static bool matches(ImFontAtlas* built, ImFontAtlas* loaded)
+{
+    if (!loaded->IsBuilt() || loaded->TexWidth != built->TexWidth || loaded->TexHeight != built->TexHeight ||
+        loaded->Fonts.Size != built->Fonts.Size || loaded->TexUvWhitePixel.x != built->TexUvWhitePixel.x ||
+        loaded->TexUvWhitePixel.y != built->TexUvWhitePixel.y)
+        return false;
+    for (int i = 0; i < baked_font_atlas::LineCount; ++i)
+    {
+        const ImVec4& a = built->TexUvLines[i];
+        const ImVec4& b = loaded->TexUvLines[i];
+        if (a.x != b.x || a.y != b.y || a.z != b.z || a.w != b.w)
+            return false;
+    }
+
+    unsigned char* built_pixels = NULL;
+    unsigned char* loaded_pixels = NULL;
+    int width = 0, height = 0;
+    built->GetTexDataAsAlpha8(&built_pixels, &width, &height);
+    loaded->GetTexDataAsAlpha8(&loaded_pixels, &width, &height);
+    if (!loaded_pixels || std::memcmp(built_pixels, loaded_pixels, static_cast<size_t>(width) * height) != 0)
+        return false;
+
+    for (int f = 0; f < built->Fonts.Size; ++f)
+    {
+        const ImFont* a = built->Fonts[f];
+        const ImFont* b = loaded->Fonts[f];
+        if (a->FontSize != b->FontSize || a->Ascent != b->Ascent || a->Descent != b->Descent ||
+            a->FallbackChar != b->FallbackChar || a->EllipsisChar != b->EllipsisChar ||
+            a->FallbackAdvanceX != b->FallbackAdvanceX || a->Glyphs.Size != b->Glyphs.Size)
+            return false;
+        for (int g = 0; g < a->Glyphs.Size; ++g)
+        {
+            const ImFontGlyph& x = a->Glyphs[g];
+            const ImFontGlyph& y = b->Glyphs[g];
+            if (x.Codepoint != y.Codepoint || x.Visible != y.Visible || x.AdvanceX != y.AdvanceX || x.X0 != y.X0 ||
+                x.Y0 != y.Y0 || x.X1 != y.X1 || x.Y1 != y.Y1 || x.U0 != y.U0 || x.V0 != y.V0 || x.U1 != y.U1 ||
+                x.V1 != y.V1)
+                return false;
+        }
+
+        // A few lookups, the last codepoints aren't in the default font and resolve to the fallback glyph.
+        const ImWchar lookups[] = { 'A', 'g', ' ', '0', a->FallbackChar, 0x2026, 0x4E00 };
+        for (ImWchar c : lookups)
+        {
+            const ImFontGlyph* x = a->FindGlyph(c);
+            const ImFontGlyph* y = b->FindGlyph(c);
+            if (!x != !y || (x && x - a->Glyphs.Data != y - b->Glyphs.Data))
+                return false;
+        }
+    }
+    return true;
+}
+
+int main(int, char**)
+{
+    ImGui::CreateContext();
+    ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+    // Same as baked_font_atlas::load_or_build() without a baked atlas.
+    atlas->Build();
+    const std::vector<uint8_t> blob = baked_font_atlas::bake(atlas);
+
+    // Checks the blob round trips before the apps rely on it.
+    ImFontAtlas check;
+    if (!baked_font_atlas::load(&check, blob.data(), blob.size()) || !matches(atlas, &check))
+    {
+        fprintf(stderr, "bake_font_atlas: the baked atlas doesn't load back\n");
+        return 1;
+    }
+
+    printf("// Generated by tools/bake_font_atlas.cpp, do not edit. See BakedFontAtlas.h.\n");
+    printf("// %dx%d atlas, %d font(s), %u bytes.\n", atlas->TexWidth, atlas->TexHeight, atlas->Fonts.Size,
+           static_cast<unsigned>(blob.size()));
+    printf("#pragma once\n\n");
+    printf("static const unsigned char baked_font_atlas_data[%u] = {", static_cast<unsigned>(blob.size()));
+    for (size_t i = 0; i < blob.size(); ++i)
+        printf("%s%u,", i % 24 ? "" : "\n    ", blob[i]);
+    printf("\n};\n");
+
+    ImGui::DestroyContext();
+    return 0;
+}
@@ -0,0 +1,366 @@
+// Minimal receiver for the telemetry stream of TelemetryExporter, to check throughput and loss.
+// Binds the given socket, decodes every packet and prints once per second how many packets, samples and events
+// arrived, the data rate and how many packets were lost (gaps in the sequence numbers) or arrived out of order.
+//
+// --check plays a session recording through a TelemetryExporter to the receiving socket instead, and checks that
+// every sample decodes like the recording has it (exit status 1 otherwise), a loopback test of the whole stream.
+//
+// Usage: telemetry_receiver [--seconds N] [--check recording] udp:port | unix:path
+//   e.g. telemetry_receiver udp:9870 & joystick_bench --telemetry udp:127.0.0.1:9870
+
+#include "Clock.h"
+#include "SessionRecording.h"
+#include "TelemetryExporter.h"
+#include "TelemetryPacket.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+struct Counters
+{
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t samples = 0;
+    uint64_t events = 0;
+    uint64_t lost = 0;
+    uint64_t reordered = 0;
+    uint64_t malformed = 0;
+
+    Counters operator-(const Counters& other) const
+    {
+        Counters delta;
+        delta.packets = packets - other.packets;
+        delta.bytes = bytes - other.bytes;
+        delta.samples = samples - other.samples;
+        delta.events = events - other.events;
+        delta.lost = lost - other.lost;
+        delta.reordered = reordered - other.reordered;
+        delta.malformed = malformed - other.malformed;
+        return delta;
+    }
+};
+
+// Counts gaps in the sequence numbers. A packet older than the newest one seen was counted as lost when the gap
+// opened, so it is taken back from the losses.
+class SequenceTracker
+{
+public:
+    void add(uint32_t sequence, Counters& counters)
+    {
+        if (!m_started)
+        {
+            m_started = true;
+            m_next = sequence + 1;
+            return;
+        }
+
+        const int32_t gap = static_cast<int32_t>(sequence - m_next);
+        if (gap >= 0)
+        {
+            counters.lost += static_cast<uint32_t>(gap);
+            m_next = sequence + 1;
+        }
+        else
+        {
+            ++counters.reordered;
+            if (counters.lost > 0)
+                --counters.lost;
+        }
+    }
+
+private:
+    bool m_started = false;
+    uint32_t m_next = 0;
+};
+
+static int open_socket(const char* source)
+{
+    int fd = -1;
+    if (std::strncmp(source, "unix:", 5) == 0)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (std::strlen(source + 5) >= sizeof(address.sun_path))
+            return -1;
+        std::strcpy(address.sun_path, source + 5);
+        unlink(address.sun_path);
+
+        fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (fd >= 0 && bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    else if (std::strncmp(source, "udp:", 4) == 0)
+    {
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<uint16_t>(std::atoi(source + 4)));
+
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd >= 0 && bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    if (fd < 0)
+        return -1;
+
+    // Bursts of a fast sender shouldn't be lost just because this loop was descheduled for a moment.
+    int buffer_size = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+
+    // Wake up regularly to print the statistics and notice the end of the run.
+    timeval timeout = { 0, 200 * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+static void print_counters(const char* label, const Counters& counters, double seconds)
+{
+    const uint64_t expected = counters.packets + counters.lost;
+    printf("%-8s %10.0f %10.0f %10.0f %10.2f %8llu %6.2f%% %8llu %8llu\n", label,
+           counters.packets / seconds, counters.samples / seconds, counters.events / seconds,
+           counters.bytes / seconds / (1024.0 * 1024.0), (unsigned long long)counters.lost,
+           expected ? 100.0 * counters.lost / expected : 0.0, (unsigned long long)counters.reordered,
+           (unsigned long long)counters.malformed);
+}
+
+// Whether a sample decoded from the stream is `expected` as the exporter got it: axes are quantized on the way, times
+// rounded to microseconds.
+static bool same_sample(const JoystickSample& expected, const JoystickSample& decoded)
+{
+    if (decoded.joystick_id != expected.joystick_id || decoded.axes_count != expected.axes_count ||
+        decoded.button_count != expected.button_count || std::fabs(decoded.timestamp - expected.timestamp) > 1e-6)
+        return false;
+    for (int i = 0; i < expected.axes_count; ++i)
+    {
+        if (session_recording::quantize_axis(decoded.axes[i]) != session_recording::quantize_axis(expected.axes[i]))
+            return false;
+    }
+    const int button_words = (expected.button_count + 31) / 32;
+    return std::memcmp(decoded.buttons, expected.buttons, button_words * sizeof(uint32_t)) == 0;
+}
+
+// Sends the recording at `path` to the socket `fd` is bound to and compares what arrives with it, sample by sample.
+// The exporter is fed no faster than its queue takes, so nothing may get lost on the way.
+static int check_loopback(const char* path, const char* source, int fd, double duration)
+{
+    SessionReplay expected;
+    SessionReplay replay;
+    if (!expected.open_file(path) || !replay.open_file(path))
+    {
+        fprintf(stderr, "Can't open recording '%s'\n", path);
+        return 1;
+    }
+
+    // The exporter's form of the address this receiver listens on.
+    const std::string destination =
+        std::strncmp(source, "udp:", 4) == 0 ? std::string("udp:127.0.0.1:") + (source + 4) : std::string(source);
+    TelemetryExporter exporter;
+    if (!exporter.start(destination.c_str()))
+    {
+        fprintf(stderr, "Can't send telemetry to '%s'\n", destination.c_str());
+        return 1;
+    }
+
+    std::atomic<bool> sent{false};
+    std::thread sender([&]() {
+        JoystickSample sample;
+        for (int count = 1; replay.next(sample); ++count)
+        {
+            while (!exporter.export_sample(sample))
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            // Paced so that the socket's receive buffer keeps up with the exporter's bursts.
+            if (count % 64 == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        exporter.stop();
+        sent = true;
+    });
+
+    Counters total;
+    SequenceTracker sequence;
+    telemetry::PacketReader reader;
+    telemetry::Record record;
+    JoystickSample sample;
+    uint8_t packet[64 * 1024];
+    uint64_t mismatched = 0;
+    uint64_t extra = 0;
+
+    const double start = now_seconds();
+    for (;;)
+    {
+        // Done once everything was sent and the socket stays quiet for a receive timeout.
+        const bool sender_done = sent;
+        const ssize_t size = recv(fd, packet, sizeof(packet), 0);
+        if (size <= 0)
+        {
+            if (sender_done || now_seconds() - start >= duration)
+                break;
+            continue;
+        }
+
+        if (!reader.open(packet, static_cast<size_t>(size)))
+        {
+            ++total.malformed;
+            continue;
+        }
+        ++total.packets;
+        sequence.add(reader.sequence(), total);
+
+        while (reader.next(record))
+        {
+            if (record.type != telemetry::RecordType_Sample)
+            {
+                ++total.events;
+                continue;
+            }
+            ++total.samples;
+            if (!expected.next(sample))
+                ++extra;
+            else if (!same_sample(sample, record.sample))
+            {
+                if (mismatched == 0)
+                    fprintf(stderr, "Sample %llu decodes differently from the recording\n",
+                            (unsigned long long)total.samples - 1);
+                ++mismatched;
+            }
+        }
+        if (reader.failed())
+            ++total.malformed;
+    }
+    sender.join();
+
+    uint64_t missing = 0;
+    while (expected.next(sample))
+        ++missing;
+
+    printf("check: %llu samples in %llu packets, %llu different, %llu missing, %llu extra, %llu lost packets, "
+           "%llu malformed, %llu records dropped, %llu packets not sent\n",
+           (unsigned long long)total.samples, (unsigned long long)total.packets, (unsigned long long)mismatched,
+           (unsigned long long)missing, (unsigned long long)extra, (unsigned long long)total.lost,
+           (unsigned long long)total.malformed, (unsigned long long)exporter.dropped(),
+           (unsigned long long)exporter.send_errors());
+    const bool ok = total.samples > 0 && mismatched == 0 && missing == 0 && extra == 0 && total.lost == 0 &&
+                    total.malformed == 0 && total.events == 0 && exporter.dropped() == 0 &&
+                    exporter.send_errors() == 0 && !expected.failed();
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    double duration = 10.0;
+    const char* source = NULL;
+    const char* check = NULL;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+            duration = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--check") == 0 && i + 1 < argc)
+            check = argv[++i];
+        else
+            source = argv[i];
+    }
+    if (!source || duration <= 0)
+    {
+        fprintf(stderr, "Usage: %s [--seconds N] [--check recording] udp:port | unix:path\n", argv[0]);
+        return 1;
+    }
+
+    const int fd = open_socket(source);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Can't listen on '%s'\n", source);
+        return 1;
+    }
+
+    if (check)
+    {
+        const int status = check_loopback(check, source, fd, duration);
+        close(fd);
+        if (std::strncmp(source, "unix:", 5) == 0)
+            unlink(source + 5);
+        return status;
+    }
+
+    printf("%-8s %10s %10s %10s %10s %8s %7s %8s %8s\n",
+           "", "packets/s", "samples/s", "events/s", "MiB/s", "lost", "loss", "reorder", "bad");
+
+    Counters total;
+    Counters last_report;
+    SequenceTracker sequence;
+    telemetry::PacketReader reader;
+    telemetry::Record record;
+    uint8_t packet[64 * 1024];
+
+    const double start = now_seconds();
+    double first_packet = 0;
+    double next_report = start + 1.0;
+    for (;;)
+    {
+        const double now = now_seconds();
+        if (now >= next_report)
+        {
+            print_counters("last 1s", total - last_report, 1.0);
+            last_report = total;
+            next_report += 1.0;
+        }
+        if (now - start >= duration)
+            break;
+
+        const ssize_t size = recv(fd, packet, sizeof(packet), 0);
+        if (size <= 0)
+            continue;
+
+        if (!reader.open(packet, static_cast<size_t>(size)))
+        {
+            ++total.malformed;
+            continue;
+        }
+        if (total.packets == 0)
+            first_packet = now_seconds();
+        ++total.packets;
+        total.bytes += static_cast<uint64_t>(size);
+        sequence.add(reader.sequence(), total);
+
+        while (reader.next(record))
+        {
+            if (record.type == telemetry::RecordType_Sample)
+                ++total.samples;
+            else
+                ++total.events;
+        }
+        if (reader.failed())
+            ++total.malformed;
+    }
+
+    const double receiving = first_packet > 0 ? now_seconds() - first_packet : 0.0;
+    printf("total: %llu packets, %llu samples, %llu events, %llu bytes\n", (unsigned long long)total.packets,
+           (unsigned long long)total.samples, (unsigned long long)total.events, (unsigned long long)total.bytes);
+    if (receiving > 0)
+        print_counters("average", total, receiving);
+
+    close(fd);
+    if (std::strncmp(source, "unix:", 5) == 0)
+        unlink(source + 5);
+    return total.lost > 0 || total.malformed > 0 ? 2 : 0;
+}